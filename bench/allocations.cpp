@@ -0,0 +1,93 @@
+// Replaces the global operator new and delete, to count allocations.
+// The aligned overloads of C++17 are not counted.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocations.hpp"
+
+
+namespace {
+
+
+std::atomic<std::size_t> allocationCount{0};
+std::atomic<std::size_t> allocationBytes{0};
+
+
+void* allocate(std::size_t size) noexcept
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	return std::malloc(size > 0 ? size : 1);
+}
+
+
+} // namespace
+
+
+bench::Allocations bench::countAllocations()
+{
+	return Allocations{
+		allocationCount.load(std::memory_order_relaxed),
+		allocationBytes.load(std::memory_order_relaxed)};
+}
+
+
+void* operator new(std::size_t size)
+{
+	if (void* p = allocate(size))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+	if (void* p = allocate(size))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	std::free(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+#endif
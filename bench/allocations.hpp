@@ -0,0 +1,38 @@
+// Counts the heap allocations of the whole program.
+// Requires allocations.cpp, which replaces the global
+// operator new and delete, in the same executable.
+
+#ifndef MINARG_ALLOCATIONS_HPP_INCLUDED
+#define MINARG_ALLOCATIONS_HPP_INCLUDED
+
+#include <cstddef>
+
+
+namespace bench {
+
+
+struct Allocations
+{
+	std::size_t count;
+	std::size_t bytes;
+};
+
+
+// Totals since program start, for all threads
+Allocations countAllocations();
+
+
+// Allocations during the operation
+template<typename Operation>
+Allocations measureAllocations(Operation&& operation)
+{
+	const Allocations before{countAllocations()};
+	operation();
+	const Allocations after{countAllocations()};
+	return Allocations{after.count - before.count, after.bytes - before.bytes};
+}
+
+
+} // namespace bench
+
+#endif // MINARG_ALLOCATIONS_HPP_INCLUDED
@@ -0,0 +1,262 @@
+// Benchmark helpers, shared by the benchmark executables.
+// Depends on nothing but the standard library and minarg.
+
+#ifndef MINARG_BENCH_HPP_INCLUDED
+#define MINARG_BENCH_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+
+#include "allocations.hpp"
+
+
+namespace bench {
+
+
+// ---- Measurement ----
+
+struct Result
+{
+	std::string name;
+	std::size_t size;
+	std::size_t iterations;
+	double nanoseconds; // Per iteration
+	double allocations; // Per iteration
+	double bytes;       // Per iteration
+};
+
+
+// Keeps a value observable, so that its computation is not optimized away
+template<typename T>
+inline void keep(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static const void* volatile sink{nullptr};
+	sink = &value;
+#endif
+}
+
+
+// Repeats the operation in doubling batches,
+// until a batch takes at least the given time.
+// Includes the allocations of the operation.
+template<typename Operation>
+Result measure(std::string name, std::size_t size, double minSeconds, Operation&& operation)
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Warm up caches, streams and lazy parser state
+	operation();
+
+	std::size_t iterations{1};
+	while (true)
+	{
+		const Allocations before{countAllocations()};
+		const Clock::time_point start{Clock::now()};
+		for (std::size_t i{0}; i < iterations; ++i)
+			operation();
+		const std::chrono::duration<double> elapsed{Clock::now() - start};
+		const Allocations after{countAllocations()};
+
+		if (elapsed.count() >= minSeconds || iterations >= (std::size_t{1} << 30))
+		{
+			const double n{static_cast<double>(iterations)};
+			return Result{
+				std::move(name),
+				size,
+				iterations,
+				elapsed.count() * 1e9 / n,
+				static_cast<double>(after.count - before.count) / n,
+				static_cast<double>(after.bytes - before.bytes) / n};
+		}
+		iterations *= 2;
+	}
+}
+
+
+// Samples the allocation counter at the start of each parse phase,
+// and sums the allocations of each phase over all parses
+class PhaseAllocations : public minarg::Observer
+{
+	public:
+
+		static const std::size_t phaseCount{static_cast<std::size_t>(Phase::done)};
+
+		static const char* getName(std::size_t phase)
+		{
+			static const char* const names[phaseCount]{
+				"setup", "utility", "options", "operands", "checks"};
+			return names[phase];
+		}
+
+		// Allocations of the phase, which ends at the start of the next
+		const Allocations& get(std::size_t phase) const
+		{
+			return totals_[phase];
+		}
+
+		std::size_t getParses() const
+		{
+			return parses_;
+		}
+
+		void clear()
+		{
+			*this = PhaseAllocations{};
+		}
+
+		void onPhase(Phase phase) override
+		{
+			const Allocations now{countAllocations()};
+			if (current_ < phaseCount)
+			{
+				totals_[current_].count += now.count - last_.count;
+				totals_[current_].bytes += now.bytes - last_.bytes;
+			}
+
+			current_ = static_cast<std::size_t>(phase);
+			if (phase == Phase::done)
+				++parses_;
+			last_ = now;
+		}
+
+	private:
+
+		Allocations totals_[phaseCount]{};
+		Allocations last_{0, 0};
+		std::size_t current_{phaseCount};
+		std::size_t parses_{0};
+};
+
+
+// ---- Output ----
+
+inline void writeCsv(std::ostream& out, const std::vector<Result>& results)
+{
+	out << "name,size,iterations,ns_per_op,allocs_per_op,bytes_per_op\n";
+	for (const auto& r : results)
+		out << r.name << ',' << r.size << ',' << r.iterations << ',' << r.nanoseconds
+			<< ',' << r.allocations << ',' << r.bytes << '\n';
+}
+
+
+inline void writeJson(std::ostream& out, const std::vector<Result>& results)
+{
+	out << "[\n";
+	for (std::size_t i{0}; i < results.size(); ++i)
+	{
+		const Result& r{results[i]};
+		out << "  {\"name\": \"" << r.name
+			<< "\", \"size\": " << r.size
+			<< ", \"iterations\": " << r.iterations
+			<< ", \"ns_per_op\": " << r.nanoseconds
+			<< ", \"allocs_per_op\": " << r.allocations
+			<< ", \"bytes_per_op\": " << r.bytes
+			<< (i + 1 < results.size() ? "},\n" : "}\n");
+	}
+	out << "]\n";
+}
+
+
+// ---- Generators ----
+
+// Unique long names without shared prefixes beyond "option-"
+inline std::string longName(std::size_t i)
+{
+	return "option-" + std::to_string(i);
+}
+
+
+// Letters for the first 52 options, none for the rest
+inline char shortName(std::size_t i)
+{
+	static const char letters[]{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+	return i < sizeof(letters) - 1 ? letters[i] : 0;
+}
+
+
+// Parser with the given number of integer options
+class Schema
+{
+	public:
+
+		explicit Schema(std::size_t optionCount)
+			: values_(optionCount, 0)
+		{
+			for (std::size_t i{0}; i < optionCount; ++i)
+				parser_.addOption(values_[i], shortName(i), longName(i), "N", "Synthetic integer option");
+		}
+
+		minarg::Parser& parser()
+		{
+			return parser_;
+		}
+
+		const std::vector<int>& values() const
+		{
+			return values_;
+		}
+
+	private:
+
+		std::vector<int> values_{};
+		minarg::Parser parser_{"Synthetic schema", "End of synthetic schema"};
+};
+
+
+// Arguments for a schema with the given number of options,
+// mixing all option formats with small integer values.
+// The result includes the utility name.
+inline std::vector<std::string> makeArgv(
+	std::size_t optionCount,
+	std::size_t tokenCount,
+	unsigned seed = 1)
+{
+	std::minstd_rand random{seed};
+	std::uniform_int_distribution<std::size_t> pick{0, optionCount - 1};
+	const std::size_t shortCount{optionCount < 52 ? optionCount : 52};
+
+	std::vector<std::string> argv{"bench"};
+	argv.reserve(tokenCount + 1);
+	while (argv.size() <= tokenCount)
+	{
+		const std::size_t i{pick(random)};
+		const std::string value{std::to_string(random() % 1000)};
+		switch (random() % 4)
+		{
+			case 0:
+				argv.push_back("--" + longName(i) + "=" + value);
+				break;
+			case 1:
+				argv.push_back("--" + longName(i));
+				argv.push_back(value);
+				break;
+			case 2:
+				argv.push_back(std::string{'-', shortName(i % shortCount)} + value);
+				break;
+			default:
+				argv.push_back(std::string{'-', shortName(i % shortCount)});
+				argv.push_back(value);
+		}
+	}
+	// A trailing option without its value would be an error
+	if (argv.size() > tokenCount + 1)
+	{
+		argv.pop_back();
+		argv.pop_back();
+	}
+	return argv;
+}
+
+
+} // namespace bench
+
+#endif // MINARG_BENCH_HPP_INCLUDED
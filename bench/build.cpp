@@ -0,0 +1,250 @@
+// Compile time and code size of translation units that include minarg.
+// Generates small sources, compiles them with the build's compiler,
+// and reports the differences to the previous baseline:
+//
+//   std     The standard headers that minarg includes, without minarg
+//   header  The minarg header, without any use
+//   parser  A parser with one bool option, parsed and printed
+//   <type>  The parser, plus one option of the type
+//
+// The code size is the sum of all .text sections in the object file,
+// and is only available for ELF objects.
+//
+// Usage: ./bench/minarg-build [--format csv|json] [--runs N]
+
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+
+
+namespace {
+
+
+enum class Format {csv, json};
+
+
+struct Unit
+{
+	std::string name;
+	std::string baseline;
+	std::string code;
+};
+
+
+struct Stats
+{
+	std::string name{};
+	double milliseconds{0};
+	long long textBytes{0};
+	double deltaMilliseconds{0};
+	long long deltaTextBytes{0};
+};
+
+
+// The standard headers that minarg includes, read from the header
+// itself, so that the list cannot get out of sync
+std::string makeStdHeaders()
+{
+	std::ifstream header{std::string{MINARG_BUILD_INCLUDE} + "/minarg/minarg.hpp"};
+	if (!header)
+		throw minarg::Error{"Cannot read minarg.hpp"};
+
+	std::string code{};
+	for (std::string line{}; std::getline(header, line); )
+		if (line.compare(0, 10, "#include <") == 0)
+			code += line + '\n';
+	return code + "int main() {}\n";
+}
+
+
+// Parser with one bool option, and optional declarations before parsing
+std::string makeParser(const std::string& declarations)
+{
+	return
+		"#include <list>\n#include <map>\n#include <minarg/minarg.hpp>\n"
+		"int main(int argc, char* argv[]) {\n"
+		"  minarg::Parser parser{};\n"
+		"  bool b{false};\n"
+		"  parser.addOption(b, 'b', \"bool\", \"\");\n" + declarations +
+		"  parser.parse(argc, argv);\n"
+		"  std::cout << parser;\n"
+		"}\n";
+}
+
+
+std::string makeOption(const std::string& type)
+{
+	return makeParser("  " + type + " v{};\n  parser.addOption(v, 'v', \"value\", \"V\", \"\");\n");
+}
+
+
+std::vector<Unit> makeUnits()
+{
+	return {
+		{"std", "", makeStdHeaders()},
+		{"header", "std", "#include <minarg/minarg.hpp>\nint main() {}\n"},
+		{"parser", "header", makeParser("")},
+		{"char", "parser", makeOption("char")},
+		{"int", "parser", makeOption("int")},
+		{"unsigned", "parser", makeOption("unsigned")},
+		{"long long", "parser", makeOption("long long")},
+		{"double", "parser", makeOption("double")},
+		{"string", "parser", makeOption("std::string")},
+		{"int sink", "parser", makeParser(
+			"  std::vector<int> v{};\n  parser.addOptionSink(v, 'v', \"value\", \"V\", \"\", ',');\n")},
+		{"string sink", "parser", makeParser(
+			"  std::vector<std::string> v{};\n  parser.addOperandSink(v, \"V\", \"\");\n")},
+		{"string list sink", "parser", makeParser(
+			"  std::list<std::string> v{};\n  parser.addOperandSink(v, \"V\", \"\");\n")},
+		{"map", "parser", makeParser(
+			"  std::map<std::string, int> v{};\n  parser.addOptionMap(v, 'v', \"value\", \"K=V\", \"\");\n")}};
+}
+
+
+// Sum of all .text sections in an ELF object, or -1
+long long getTextBytes(const std::string& path)
+{
+	std::ifstream file{path, std::ios::binary};
+	const std::vector<char> data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+	const auto read = [&](std::size_t pos, std::size_t size) -> std::uint64_t
+	{
+		std::uint64_t value{0};
+		for (std::size_t i{0}; i < size && pos + i < data.size(); ++i)
+			value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+		return value;
+	};
+
+	// Only 64-bit little-endian ELF
+	if (data.size() < 64 || data[0] != 0x7f || data[1] != 'E' || data[4] != 2 || data[5] != 1)
+		return -1;
+
+	const std::uint64_t tableOffset{read(0x28, 8)};
+	const std::uint64_t entrySize{read(0x3a, 2)};
+	const std::uint64_t entryCount{read(0x3c, 2)};
+	const std::uint64_t namesIndex{read(0x3e, 2)};
+	const std::uint64_t namesOffset{read(tableOffset + namesIndex * entrySize + 0x18, 8)};
+
+	long long sum{0};
+	for (std::uint64_t i{0}; i < entryCount; ++i)
+	{
+		const std::uint64_t entry{tableOffset + i * entrySize};
+		const std::uint64_t nameOffset{namesOffset + read(entry, 4)};
+		if (nameOffset + 5 <= data.size() && std::string(&data[nameOffset], 5) == ".text")
+			sum += static_cast<long long>(read(entry + 0x20, 8));
+	}
+	return sum;
+}
+
+
+// Best compile time of several runs
+Stats compile(const Unit& unit, const std::string& directory, int runs)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::string base{directory + "/unit-" + unit.name};
+	for (char& c : base)
+		if (c == ' ')
+			c = '-';
+
+	std::ofstream{base + ".cpp"} << unit.code;
+
+	const std::string command{
+		std::string{MINARG_BUILD_COMPILER} + " -std=c++11 -O2 -I\"" + MINARG_BUILD_INCLUDE + "\""
+		" -c \"" + base + ".cpp\" -o \"" + base + ".o\""};
+
+	Stats stats{};
+	stats.name = unit.name;
+	for (int run{0}; run < runs; ++run)
+	{
+		const Clock::time_point start{Clock::now()};
+		if (std::system(command.c_str()) != 0)
+			throw minarg::Error{"Cannot compile: " + base + ".cpp"};
+		const std::chrono::duration<double, std::milli> elapsed{Clock::now() - start};
+		if (run == 0 || elapsed.count() < stats.milliseconds)
+			stats.milliseconds = elapsed.count();
+	}
+	stats.textBytes = getTextBytes(base + ".o");
+	return stats;
+}
+
+
+void writeCsv(std::ostream& out, const std::vector<Stats>& results)
+{
+	out << "name,compile_ms,text_bytes,delta_compile_ms,delta_text_bytes\n";
+	for (const auto& s : results)
+		out << s.name << ',' << s.milliseconds << ',' << s.textBytes
+			<< ',' << s.deltaMilliseconds << ',' << s.deltaTextBytes << '\n';
+}
+
+
+void writeJson(std::ostream& out, const std::vector<Stats>& results)
+{
+	out << "[\n";
+	for (std::size_t i{0}; i < results.size(); ++i)
+	{
+		const Stats& s{results[i]};
+		out << "  {\"name\": \"" << s.name
+			<< "\", \"compile_ms\": " << s.milliseconds
+			<< ", \"text_bytes\": " << s.textBytes
+			<< ", \"delta_compile_ms\": " << s.deltaMilliseconds
+			<< ", \"delta_text_bytes\": " << s.deltaTextBytes
+			<< (i + 1 < results.size() ? "},\n" : "}\n");
+	}
+	out << "]\n";
+}
+
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+	Format format{Format::csv};
+	int runs{3};
+
+	minarg::Parser parser{"Measures the compile time and code size of minarg"};
+	parser.addSignal('h', "help", "Show help and exit");
+	parser.addOption(format, 'f', "format", "FORMAT", "Output format",
+		{{"csv", Format::csv}, {"json", Format::json}});
+	parser.addOption(runs, 'r', "runs", "N", "Compilations per unit");
+
+	std::vector<Stats> results{};
+	try {
+		parser.parse(argc, argv);
+		if (runs <= 0)
+			throw minarg::Error{"Runs must be positive"};
+
+		for (const Unit& unit : makeUnits())
+		{
+			Stats stats{compile(unit, MINARG_BUILD_DIR, runs)};
+			for (const Stats& baseline : results)
+				if (baseline.name == unit.baseline)
+				{
+					stats.deltaMilliseconds = stats.milliseconds - baseline.milliseconds;
+					stats.deltaTextBytes = stats.textBytes - baseline.textBytes;
+				}
+			results.push_back(stats);
+		}
+	}
+	catch (const minarg::Signal&) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (format == Format::json)
+		writeJson(std::cout, results);
+	else
+		writeCsv(std::cout, results);
+}
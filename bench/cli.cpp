@@ -0,0 +1,45 @@
+// Example utility for the startup benchmark, with a schema of
+// MINARG_CLI_OPTIONS integer options and a sink of file operands.
+// The option registrations are generated by bench/CMakeLists.txt
+// into cli-schema.inc, so that the code grows with the schema,
+// like in a hand-written utility.
+// Without options, it is the baseline that includes no minarg code.
+
+#include <cstdlib>
+#include <iostream>
+
+#if MINARG_CLI_OPTIONS > 0
+#include <string>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+
+namespace {
+#include "cli-schema.inc"
+} // namespace
+#endif
+
+
+int main(int argc, char* argv[])
+{
+#if MINARG_CLI_OPTIONS > 0
+	int values[MINARG_CLI_OPTIONS]{};
+	std::vector<std::string> files{};
+
+	minarg::Parser parser{"Synthetic schema", "End of synthetic schema"};
+	addOptions(parser, values);
+	parser.addOperandSink(files, "FILE", "Input file");
+
+	try {
+		parser.parse(argc, argv);
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+#else
+	static_cast<void>(argc);
+	static_cast<void>(argv);
+#endif
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,289 @@
+// Compares minarg with getopt_long and a hand-written parser,
+// on the same schema and arguments. Reports the time and
+// allocations per argument token, the conversion cost,
+// and the setup cost before the first parse.
+//
+// Usage: ./bench/minarg-compare [--format csv|json] [--time SECONDS]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <getopt.h>
+#endif
+
+#include <minarg/minarg.hpp>
+
+#include "bench.hpp"
+
+
+namespace {
+
+
+enum class Format {csv, json};
+
+
+// Targets of the common schema
+struct Targets
+{
+	bool verbose{false};
+	bool quiet{false};
+	int count{0};
+	int jobs{0};
+	int level{0};
+	std::string output{};
+	std::string input{};
+	std::string name{};
+};
+
+
+// Mixes all option formats that every parser supports
+std::vector<std::string> makeArgv(std::size_t tokenCount)
+{
+	static const char* const forms[][2]{
+		{"-v", nullptr},
+		{"-vq", nullptr},
+		{"--verbose", nullptr},
+		{"--quiet", nullptr},
+		{"-n5", nullptr},
+		{"-j", "12"},
+		{"--count=42", nullptr},
+		{"--jobs", "8"},
+		{"--level=3", nullptr},
+		{"-ofile.txt", nullptr},
+		{"--input", "/usr/share/data.txt"},
+		{"--name=example", nullptr}};
+
+	std::minstd_rand random{1};
+	std::vector<std::string> argv{"compare"};
+	while (argv.size() <= tokenCount)
+	{
+		const auto& form = forms[random() % (sizeof(forms) / sizeof(forms[0]))];
+		argv.emplace_back(form[0]);
+		if (form[1] != nullptr)
+			argv.emplace_back(form[1]);
+	}
+	argv.resize(tokenCount + 1);
+	if (argv.back() == "-j" || argv.back() == "--jobs" || argv.back() == "--input")
+		argv.back() = "-v";
+	return argv;
+}
+
+
+void addSchema(minarg::Parser& parser, Targets& t)
+{
+	parser.addOption(t.verbose, 'v', "verbose", "Verbose output");
+	parser.addOption(t.quiet,   'q', "quiet",   "Quiet output");
+	parser.addOption(t.count,   'n', "count",  "N",    "Item count");
+	parser.addOption(t.jobs,    'j', "jobs",   "N",    "Job count");
+	parser.addOption(t.level,    0 , "level",  "N",    "Level");
+	parser.addOption(t.output,  'o', "output", "FILE", "Output file");
+	parser.addOption(t.input,   'i', "input",  "FILE", "Input file");
+	parser.addOption(t.name,     0 , "name",   "NAME", "Name");
+}
+
+
+// ---- Hand-written parser ----
+
+int toInt(const char* s)
+{
+	char* end{nullptr};
+	const long value{std::strtol(s, &end, 10)};
+	if (end == s || *end != '\0')
+		throw minarg::Error{"Invalid integer"};
+	return static_cast<int>(value);
+}
+
+
+// Assigns the value of a long option,
+// returns false for options without value
+bool setLong(Targets& t, const char* name, std::size_t size, const char* value)
+{
+	const auto is = [&](const char* s){ return std::strlen(s) == size && std::strncmp(name, s, size) == 0; };
+
+	if (is("verbose")) t.verbose = true;
+	else if (is("quiet")) t.quiet = true;
+	else if (is("count")) { t.count = toInt(value); return true; }
+	else if (is("jobs")) { t.jobs = toInt(value); return true; }
+	else if (is("level")) { t.level = toInt(value); return true; }
+	else if (is("output")) { t.output = value; return true; }
+	else if (is("input")) { t.input = value; return true; }
+	else if (is("name")) { t.name = value; return true; }
+	else throw minarg::Error{"Unknown option"};
+	return false;
+}
+
+
+void parseByHand(Targets& t, int argc, const char* const argv[])
+{
+	for (int i{1}; i < argc; ++i)
+	{
+		const char* arg{argv[i]};
+		if (arg[0] != '-')
+			throw minarg::Error{"Unexpected operand"};
+
+		if (arg[1] == '-')
+		{
+			const char* name{arg + 2};
+			const char* sep{std::strchr(name, '=')};
+			const std::size_t size{sep != nullptr ? static_cast<std::size_t>(sep - name) : std::strlen(name)};
+			const char* value{sep != nullptr ? sep + 1 : (i + 1 < argc ? argv[i + 1] : nullptr)};
+			if (setLong(t, name, size, value) && sep == nullptr)
+				++i;
+			continue;
+		}
+
+		for (const char* c{arg + 1}; *c != '\0'; ++c)
+		{
+			if (*c == 'v') { t.verbose = true; continue; }
+			if (*c == 'q') { t.quiet = true; continue; }
+
+			const char* value{c[1] != '\0' ? c + 1 : argv[++i]};
+			switch (*c)
+			{
+				case 'n': t.count = toInt(value); break;
+				case 'j': t.jobs = toInt(value); break;
+				case 'o': t.output = value; break;
+				case 'i': t.input = value; break;
+				default: throw minarg::Error{"Unknown option"};
+			}
+			break;
+		}
+	}
+}
+
+
+// ---- getopt_long ----
+
+#if defined(__GLIBC__)
+
+const option longOptions[]{
+	{"verbose", no_argument,       nullptr, 'v'},
+	{"quiet",   no_argument,       nullptr, 'q'},
+	{"count",   required_argument, nullptr, 'n'},
+	{"jobs",    required_argument, nullptr, 'j'},
+	{"level",   required_argument, nullptr, 'l'},
+	{"output",  required_argument, nullptr, 'o'},
+	{"input",   required_argument, nullptr, 'i'},
+	{"name",    required_argument, nullptr, 'N'},
+	{nullptr,   0,                 nullptr, 0}};
+
+
+void parseByGetopt(Targets& t, int argc, char* argv[])
+{
+	optind = 0; // Reinitialize glibc
+	opterr = 0;
+
+	int c{0};
+	while ((c = getopt_long(argc, argv, "+vqn:j:o:i:", longOptions, nullptr)) != -1)
+		switch (c)
+		{
+			case 'v': t.verbose = true; break;
+			case 'q': t.quiet = true; break;
+			case 'n': t.count = toInt(optarg); break;
+			case 'j': t.jobs = toInt(optarg); break;
+			case 'l': t.level = toInt(optarg); break;
+			case 'o': t.output = optarg; break;
+			case 'i': t.input = optarg; break;
+			case 'N': t.name = optarg; break;
+			default: throw minarg::Error{"Unknown option"};
+		}
+}
+
+#endif
+
+
+// Converts the totals to costs per token
+bench::Result perToken(bench::Result r)
+{
+	const double n{static_cast<double>(r.size)};
+	r.nanoseconds /= n;
+	r.allocations /= n;
+	r.bytes /= n;
+	return r;
+}
+
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+	Format format{Format::csv};
+	double seconds{0.1};
+
+	minarg::Parser parser{"Compares minarg with getopt_long and a hand-written parser"};
+	parser.addSignal('h', "help", "Show help and exit");
+	parser.addOption(format, 'f', "format", "FORMAT", "Output format",
+		{{"csv", Format::csv}, {"json", Format::json}});
+	parser.addOption(seconds, 't', "time", "SECONDS", "Minimum time per benchmark");
+
+	try {
+		parser.parse(argc, argv);
+	}
+	catch (const minarg::Signal&) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<bench::Result> results{};
+
+	// Setup before the first parse, with one token
+	{
+		const std::vector<std::string> args{"compare", "-v"};
+		results.push_back(bench::measure("setup/minarg", 1, seconds, [&]
+		{
+			Targets t{};
+			minarg::Parser p{};
+			addSchema(p, t);
+			p.parse(args);
+			bench::keep(t);
+		}));
+	}
+
+	for (std::size_t tokens : {64, 4096})
+	{
+		const std::vector<std::string> args{makeArgv(tokens)};
+		std::vector<char*> pointers{};
+		for (const auto& arg : args)
+			pointers.push_back(const_cast<char*>(arg.c_str()));
+		const int count{static_cast<int>(pointers.size())};
+
+		Targets t{};
+		minarg::Parser p{};
+		addSchema(p, t);
+
+		results.push_back(perToken(bench::measure("token/minarg-argv", tokens, seconds,
+			[&]{ p.parse(count, pointers.data()); })));
+		results.push_back(perToken(bench::measure("token/minarg-vector", tokens, seconds,
+			[&]{ p.parse(args); })));
+#if defined(__GLIBC__)
+		results.push_back(perToken(bench::measure("token/getopt_long", tokens, seconds,
+			[&]{ parseByGetopt(t, count, pointers.data()); })));
+#endif
+		results.push_back(perToken(bench::measure("token/hand", tokens, seconds,
+			[&]{ parseByHand(t, count, pointers.data()); })));
+	}
+
+	// Conversion of one integer
+	{
+		const std::string value{"65535"};
+		results.push_back(bench::measure("convert/minarg", 1, seconds,
+			[&]{ bench::keep(minarg::detail::fromString<int>(value)); }));
+		results.push_back(bench::measure("convert/strtol", 1, seconds,
+			[&]{ bench::keep(toInt(value.c_str())); }));
+	}
+
+	if (format == Format::json)
+		bench::writeJson(std::cout, results);
+	else
+		bench::writeCsv(std::cout, results);
+}
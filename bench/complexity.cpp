@@ -0,0 +1,293 @@
+// Guards against superlinear complexity on adversarial input.
+// Each case is timed at a base size and at multiples of it,
+// and fails when the time grows faster than the size allows.
+//
+// Usage: ./bench/minarg-complexity [--exponent E] [--match TEXT]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+
+#include "bench.hpp"
+
+
+namespace {
+
+
+using Operation = std::function<void()>;
+
+
+struct Case
+{
+	std::string name;
+	std::size_t baseSize;
+	std::function<Operation(std::size_t)> prepare;
+};
+
+
+// Parser and arguments, owned by the prepared operation
+struct Input
+{
+	minarg::Parser parser{};
+	std::vector<std::string> argv{};
+	std::vector<std::string> strings{};
+	std::vector<std::vector<int>> sinks{};
+	std::vector<std::unordered_map<std::string, std::string>> maps{};
+	std::string text{};
+	bool flag{false};
+	std::ostringstream out{};
+};
+
+
+// Long clusters of short options, in parseShortOptions
+Operation prepareShortCluster(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	for (char c{'a'}; c <= 'z'; ++c)
+		in->parser.addOption(in->flag, c, "", "");
+
+	std::string token{"-"};
+	for (std::size_t i{0}; i < size; ++i)
+		token += static_cast<char>('a' + i % 26);
+	in->argv = {"", token};
+	return [in]{ in->parser.parse(in->argv); };
+}
+
+
+// Values full of separators, in parseLongOption
+Operation prepareSeparators(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	in->parser.addOption(in->text, 's', "sss", "", "");
+	in->argv = {"", "--sss=" + std::string(size, '='), "--sss", std::string(size, '=')};
+	return [in]{ in->parser.parse(in->argv); };
+}
+
+
+// Long option names that only differ in the last character
+Operation prepareSharedPrefixes(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	const std::string prefix(size, 'x');
+	in->strings.resize(64);
+	for (std::size_t i{0}; i < 64; ++i)
+		in->parser.addOption(in->strings[i], 0, prefix + std::to_string(i), "", "");
+
+	in->argv = {""};
+	for (std::size_t i{0}; i < 64; ++i)
+		in->argv.push_back("--" + prefix + std::to_string(i) + "=" + prefix);
+	return [in]{ in->parser.parse(in->argv); };
+}
+
+
+// Many long names with a shared prefix, and unknown names that are
+// close to them, including the suggestions. The names stay within
+// the 64 chars that the edit distance supports.
+Operation prepareUnknownPrefixes(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	const std::string prefix(32, 'x');
+	in->strings.resize(size);
+	for (std::size_t i{0}; i < size; ++i)
+		in->parser.addOption(in->strings[i], 0, prefix + std::to_string(i), "", "");
+
+	in->argv = {""};
+	for (std::size_t i{0}; i < 64; ++i)
+		in->argv.push_back("--" + prefix + "?" + std::to_string(i * size / 64));
+	return [in]{ bench::keep(in->parser.validate(in->argv)); };
+}
+
+
+// Many sink options, each used once, in parseLongOption
+Operation prepareSinkOptions(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	in->sinks.resize(size);
+	for (std::size_t i{0}; i < size; ++i)
+		in->parser.addOptionSink(in->sinks[i], 0, "o" + std::to_string(i), "", "", 0);
+
+	in->argv = {""};
+	for (std::size_t i{0}; i < size; ++i)
+		in->argv.push_back("--o" + std::to_string(i) + "=1");
+	return [in]
+	{
+		for (auto& sink : in->sinks)
+			sink.clear();
+		in->parser.parse(in->argv);
+	};
+}
+
+
+// Many map options, each used once, in reserveValues and parseLongOption
+Operation prepareMapOptions(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	in->maps.resize(size);
+	for (std::size_t i{0}; i < size; ++i)
+		in->parser.addOptionMap(in->maps[i], 0, "o" + std::to_string(i), "", "");
+
+	in->argv = {""};
+	for (std::size_t i{0}; i < size; ++i)
+		in->argv.push_back("--o" + std::to_string(i) + "=k=v");
+	return [in]
+	{
+		for (auto& map : in->maps)
+			map.clear();
+		in->parser.parse(in->argv);
+	};
+}
+
+
+// Words wider than the help width, in tokenize and writeWrapped
+Operation prepareWideWords(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	std::string description{};
+	while (description.size() < size)
+		description += std::string(200, 'w') + ' ';
+	in->parser.addOption(in->text, 's', "sss", "S", description);
+	return [in]
+	{
+		in->out.str({});
+		in->out << in->parser;
+	};
+}
+
+
+// Many short words and line breaks, in tokenize and writeWrapped
+Operation prepareManyWords(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	std::string description{};
+	while (description.size() < size)
+		description += "word word\n";
+	in->parser.addOption(in->text, 's', "sss", "S", description);
+	return [in]
+	{
+		in->out.str({});
+		in->out << in->parser;
+	};
+}
+
+
+// Millions of operands, in parseOperandContent
+Operation prepareOperands(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	in->parser.addOperandSink(in->strings, "", "");
+	in->argv.assign(size + 1, "operand");
+	return [in]
+	{
+		in->strings.clear();
+		in->parser.parse(in->argv);
+	};
+}
+
+
+// Long command lines with quotes and escapes, in splitCommandLine
+Operation prepareCommandLine(std::size_t size)
+{
+	std::shared_ptr<Input> in{new Input{}};
+	in->parser.addOperandSink(in->strings, "", "");
+	in->text = "utility";
+	while (in->text.size() < size)
+		in->text += " 'single quoted' \"double \\\" quoted\" esc\\ aped";
+	return [in]
+	{
+		in->strings.clear();
+		in->parser.parseCommandLine(in->text);
+	};
+}
+
+
+// Best of several runs, in nanoseconds
+double measureTime(const Operation& operation)
+{
+	using Clock = std::chrono::steady_clock;
+
+	double best{0};
+	for (int run{0}; run < 5; ++run)
+	{
+		const Clock::time_point start{Clock::now()};
+		operation();
+		const std::chrono::duration<double, std::nano> elapsed{Clock::now() - start};
+		if (run == 0 || elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best;
+}
+
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+	double maxExponent{1.4};
+	std::string match{};
+
+	minarg::Parser parser{"Fails if parsing or help rendering grows superlinearly"};
+	parser.addSignal('h', "help", "Show help and exit");
+	parser.addOption(maxExponent, 'e', "exponent", "E", "Maximum growth exponent");
+	parser.addOption(match, 'm', "match", "TEXT", "Run only cases whose name contains TEXT");
+
+	try {
+		parser.parse(argc, argv);
+	}
+	catch (const minarg::Signal&) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<Case> cases{
+		{"short-cluster", 1 << 14, prepareShortCluster},
+		{"separators", 1 << 14, prepareSeparators},
+		{"shared-prefixes", 1 << 8, prepareSharedPrefixes},
+		{"unknown-prefixes", 1 << 10, prepareUnknownPrefixes},
+		{"sink-options", 1 << 11, prepareSinkOptions},
+		{"map-options", 1 << 11, prepareMapOptions},
+		{"wide-words", 1 << 14, prepareWideWords},
+		{"many-words", 1 << 14, prepareManyWords},
+		{"operands", 1 << 16, prepareOperands},
+		{"command-line", 1 << 14, prepareCommandLine}};
+
+	// The largest size is 16 times the base size, so the
+	// time grows 16 times if linear, 256 times if quadratic
+	const std::size_t factors[]{1, 2, 4, 8, 16};
+
+	bool isLinear{true};
+	std::cout << "name,size,ns,exponent,status\n";
+	for (const auto& c : cases)
+	{
+		if (c.name.find(match) == std::string::npos)
+			continue;
+
+		std::vector<double> times{};
+		for (std::size_t factor : factors)
+		{
+			const std::size_t size{c.baseSize * factor};
+			times.push_back(measureTime(c.prepare(size)));
+			std::cout << c.name << ',' << size << ',' << times.back() << ",,\n";
+		}
+
+		const double exponent{std::log(times.back() / times.front()) / std::log(16.0)};
+		const bool isPass{exponent <= maxExponent};
+		isLinear = isLinear && isPass;
+		std::cout << c.name << ",,," << exponent << ',' << (isPass ? "pass" : "FAIL") << std::endl;
+	}
+
+	return isLinear ? EXIT_SUCCESS : EXIT_FAILURE;
+}
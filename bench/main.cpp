@@ -0,0 +1,379 @@
+// Throughput benchmarks for parsing, option lookup,
+// value conversion, and help rendering.
+//
+// Usage: ./bench/minarg-bench [--format csv|json] [--time SECONDS] [--match TEXT]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+
+#include "bench.hpp"
+
+
+namespace {
+
+
+enum class Format {csv, json};
+
+
+struct Config
+{
+	double seconds{0.1};
+	std::string match{};
+	std::vector<bench::Result> results{};
+
+	bool isSelected(const std::string& name) const
+	{
+		return name.find(match) != std::string::npos;
+	}
+};
+
+
+// Construction and add* calls against the number of options
+void benchSchema(Config& config)
+{
+	if (!config.isSelected("schema/options"))
+		return;
+
+	for (std::size_t options : {16, 256, 4096})
+		config.results.push_back(bench::measure("schema/options", options, config.seconds,
+			[&]
+			{
+				bench::Schema schema{options};
+				bench::keep(schema);
+			}));
+}
+
+
+// First parse after construction, which builds the index.
+// Includes the construction, see schema/options.
+void benchParseFirst(Config& config)
+{
+	if (!config.isSelected("parse/first"))
+		return;
+
+	for (std::size_t options : {16, 256, 4096})
+	{
+		const std::vector<std::string> argv{bench::makeArgv(options, 16)};
+		config.results.push_back(bench::measure("parse/first", options, config.seconds,
+			[&]
+			{
+				bench::Schema schema{options};
+				schema.parser().parse(argv);
+			}));
+	}
+}
+
+
+// Throughput against the number of arguments
+void benchParseTokens(Config& config)
+{
+	if (!config.isSelected("parse/tokens"))
+		return;
+
+	for (std::size_t tokens : {16, 256, 4096, 65536})
+	{
+		bench::Schema schema{64};
+		const std::vector<std::string> argv{bench::makeArgv(64, tokens)};
+		config.results.push_back(bench::measure("parse/tokens", tokens, config.seconds,
+			[&]{ schema.parser().parse(argv); }));
+	}
+}
+
+
+// Through parse(argc, argv), which parses views without copies
+void benchParseArgv(Config& config)
+{
+	if (!config.isSelected("parse/argv"))
+		return;
+
+	for (std::size_t tokens : {16, 256, 4096})
+	{
+		bench::Schema schema{64};
+		const std::vector<std::string> args{bench::makeArgv(64, tokens)};
+		std::vector<const char*> argv{};
+		for (const auto& arg : args)
+			argv.push_back(arg.c_str());
+
+		const int argc{static_cast<int>(argv.size())};
+		config.results.push_back(bench::measure("parse/argv", tokens, config.seconds,
+			[&]{ schema.parser().parse(argc, argv.data()); }));
+	}
+}
+
+
+// Includes the split of the line into tokens
+void benchParseCommandLine(Config& config)
+{
+	if (!config.isSelected("parse/command-line"))
+		return;
+
+	for (std::size_t tokens : {16, 256, 4096})
+	{
+		bench::Schema schema{64};
+		std::string line{};
+		for (const auto& arg : bench::makeArgv(64, tokens))
+			line += (line.empty() ? "" : " ") + arg;
+
+		config.results.push_back(bench::measure("parse/command-line", tokens, config.seconds,
+			[&]{ schema.parser().parseCommandLine(line); }));
+	}
+}
+
+
+// Allocations and bytes of each parse phase, per parse, for the first
+// parse after construction and for a reparse. The views of argv are
+// created before the setup phase, and are not part of any phase. The
+// time is that of the whole parse, including the construction for the
+// first parse.
+void benchPhases(Config& config)
+{
+	if (!config.isSelected("phase/"))
+		return;
+
+	const std::vector<std::string> argv{bench::makeArgv(64, 256)};
+	for (bool isFirst : {true, false})
+	{
+		bench::PhaseAllocations phases{};
+		bench::Schema reused{64};
+		reused.parser().parse(argv);
+		reused.parser().setObserver(&phases);
+
+		const bench::Result total{bench::measure("phase", argv.size() - 1, config.seconds,
+			[&]
+			{
+				if (isFirst)
+				{
+					bench::Schema schema{64};
+					schema.parser().setObserver(&phases);
+					schema.parser().parse(argv);
+				}
+				else
+					reused.parser().parse(argv);
+			})};
+
+		const double n{static_cast<double>(phases.getParses())};
+		for (std::size_t i{0}; i < bench::PhaseAllocations::phaseCount; ++i)
+		{
+			const std::string name{std::string{"phase/"} + (isFirst ? "first/" : "reparse/")
+				+ bench::PhaseAllocations::getName(i)};
+			if (config.isSelected(name))
+				config.results.push_back(bench::Result{name, total.size, total.iterations,
+					total.nanoseconds,
+					static_cast<double>(phases.get(i).count) / n,
+					static_cast<double>(phases.get(i).bytes) / n});
+		}
+	}
+}
+
+
+// Lookup cost against the number of options
+void benchLookupLong(Config& config)
+{
+	if (!config.isSelected("lookup/long"))
+		return;
+
+	for (std::size_t options : {16, 256, 4096})
+	{
+		bench::Schema schema{options};
+		std::vector<std::string> argv{"bench"};
+		for (std::size_t i{0}; i < 256; ++i)
+			argv.push_back("--" + bench::longName(i * 7919 % options) + "=1");
+
+		config.results.push_back(bench::measure("lookup/long", options, config.seconds,
+			[&]{ schema.parser().parse(argv); }));
+	}
+}
+
+
+// The index against the linear search of earlier versions, in small
+// schemas, with the same names and without the rest of the parse
+void benchLookupIndex(Config& config)
+{
+	const bool isIndex{config.isSelected("lookup/long-index")};
+	const bool isLinear{config.isSelected("lookup/long-linear")};
+	if (!isIndex && !isLinear)
+		return;
+
+	for (std::size_t options : {4, 16, 64})
+	{
+		std::unique_ptr<bool[]> values{new bool[options]()};
+		std::vector<std::unique_ptr<minarg::detail::Arg>> args{};
+		minarg::detail::OptionIndex index{};
+		for (std::size_t i{0}; i < options; ++i)
+		{
+			args.emplace_back(new minarg::detail::BoolArg{0, bench::longName(i), "", false, values[i]});
+			index.insert(args.back().get());
+		}
+		index.build();
+
+		std::vector<std::string> names{};
+		for (std::size_t i{0}; i < 256; ++i)
+			names.push_back(bench::longName(i * 7919 % options) + "=1");
+
+		if (isIndex)
+			config.results.push_back(bench::measure("lookup/long-index", options, config.seconds,
+				[&]
+				{
+					for (const auto& name : names)
+					{
+						const char* it{name.data()};
+						bench::keep(index.findLong(it, name.data() + name.size(), '=', false));
+					}
+				}));
+
+		if (isLinear)
+			config.results.push_back(bench::measure("lookup/long-linear", options, config.seconds,
+				[&]
+				{
+					for (const auto& name : names)
+					{
+						const std::string longName{name.begin(), std::find(name.begin(), name.end(), '=')};
+						const minarg::detail::Arg* option{nullptr};
+						for (const auto& arg : args)
+							if (arg->getLongName() == longName)
+							{
+								option = arg.get();
+								break;
+							}
+						bench::keep(option);
+					}
+				}));
+	}
+}
+
+
+void benchLookupShort(Config& config)
+{
+	if (!config.isSelected("lookup/short"))
+		return;
+
+	for (std::size_t options : {16, 52})
+	{
+		bench::Schema schema{options};
+		std::vector<std::string> argv{"bench"};
+		for (std::size_t i{0}; i < 256; ++i)
+			argv.push_back(std::string{'-', bench::shortName(i * 31 % options), '1'});
+
+		config.results.push_back(bench::measure("lookup/short", options, config.seconds,
+			[&]{ schema.parser().parse(argv); }));
+	}
+}
+
+
+// Unknown long option against the number of flags, which computes
+// the suggestions. The names are too long for inline string storage.
+void benchSuggest(Config& config)
+{
+	if (!config.isSelected("suggest/flags"))
+		return;
+
+	for (std::size_t flags : {16, 256, 4096, 16384})
+	{
+		std::unique_ptr<bool[]> values{new bool[flags]()};
+		minarg::Parser parser{};
+		for (std::size_t i{0}; i < flags; ++i)
+			parser.addOption(values[i], 0, "generated-flag-" + std::to_string(i), "");
+
+		const std::vector<std::string> argv{"bench", "--generated-falg-" + std::to_string(flags / 2)};
+		config.results.push_back(bench::measure("suggest/flags", flags, config.seconds,
+			[&]{ bench::keep(parser.validate(argv)); }));
+	}
+}
+
+
+template<typename T>
+void benchConvert(Config& config, const std::string& name, std::vector<std::string> values)
+{
+	if (!config.isSelected(name))
+		return;
+
+	config.results.push_back(bench::measure(name, values.size(), config.seconds,
+		[&]
+		{
+			for (const auto& value : values)
+				bench::keep(minarg::detail::fromString<T>(value));
+		}));
+}
+
+
+void benchConvert(Config& config)
+{
+	benchConvert<int>(config, "convert/int", {"0", "-1", "42", "65535", "-2147483648", "0x7fff"});
+	benchConvert<unsigned long>(config, "convert/unsigned", {"0", "1", "42", "65535", "4294967295", "0xffff"});
+	benchConvert<double>(config, "convert/double", {"0", "-1.5", "3.14159", "1e10", "2.5e-3", "1.0e+300"});
+	benchConvert<std::string>(config, "convert/string", {"", "a", "file.txt", "/usr/local/share/minarg"});
+}
+
+
+// Rendering cost against the number of options
+void benchHelp(Config& config)
+{
+	if (!config.isSelected("help/options"))
+		return;
+
+	for (std::size_t options : {16, 256, 4096})
+	{
+		bench::Schema schema{options};
+		std::ostringstream out{};
+		config.results.push_back(bench::measure("help/options", options, config.seconds,
+			[&]
+			{
+				out.str({});
+				out << schema.parser();
+			}));
+	}
+}
+
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+	Config config{};
+	Format format{Format::csv};
+
+	minarg::Parser parser{"Runs the minarg benchmarks and prints the time per operation"};
+	parser.addSignal('h', "help", "Show help and exit");
+	parser.addOption(format, 'f', "format", "FORMAT", "Output format",
+		{{"csv", Format::csv}, {"json", Format::json}});
+	parser.addOption(config.seconds, 't', "time", "SECONDS", "Minimum time per benchmark");
+	parser.addOption(config.match, 'm', "match", "TEXT", "Run only benchmarks whose name contains TEXT");
+
+	try {
+		parser.parse(argc, argv);
+	}
+	catch (const minarg::Signal&) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	benchSchema(config);
+	benchParseFirst(config);
+	benchParseTokens(config);
+	benchParseArgv(config);
+	benchParseCommandLine(config);
+	benchPhases(config);
+	benchLookupLong(config);
+	benchLookupIndex(config);
+	benchLookupShort(config);
+	benchSuggest(config);
+	benchConvert(config);
+	benchHelp(config);
+
+	if (format == Format::json)
+		bench::writeJson(std::cout, config.results);
+	else
+		bench::writeCsv(std::cout, config.results);
+}
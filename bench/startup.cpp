@@ -0,0 +1,191 @@
+// Startup latency of the example utilities, from fork
+// to the exit after parsing, and their binary sizes.
+// The minarg share is the difference of the minimum latency
+// to the baseline, which is the first utility. The minimum
+// is least affected by scheduling and fork noise. A share
+// below zero is within the noise, and reported as zero.
+//
+// Usage: ./bench/minarg-startup [--format csv|json] [--runs N] [UTILITY]...
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+
+
+namespace {
+
+
+enum class Format {csv, json};
+
+
+struct Stats
+{
+	std::string name{};
+	long long bytes{0};
+	std::size_t runs{0};
+	double min{0};
+	double p50{0};
+	double p90{0};
+	double p99{0};
+	double max{0};
+	double share{0};
+};
+
+
+// Arguments that every example utility accepts
+const char* const exampleArgs[]{"-a", "1", "--option-0=2", "-a3", "input.txt", nullptr};
+
+
+long long getFileSize(const std::string& path)
+{
+	struct stat info{};
+	return stat(path.c_str(), &info) == 0 ? static_cast<long long>(info.st_size) : -1;
+}
+
+
+// Nanoseconds from fork to the end of the child
+double runOnce(const std::string& path)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<const char*> argv{path.c_str()};
+	argv.insert(argv.end(), std::begin(exampleArgs), std::end(exampleArgs));
+
+	const Clock::time_point start{Clock::now()};
+	const pid_t pid{fork()};
+	if (pid == 0)
+	{
+		execv(path.c_str(), const_cast<char* const*>(argv.data()));
+		_exit(127);
+	}
+
+	int status{0};
+	if (pid < 0 || waitpid(pid, &status, 0) != pid
+		|| !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+		throw minarg::Error{"Cannot run utility: " + path};
+
+	const std::chrono::duration<double, std::nano> elapsed{Clock::now() - start};
+	return elapsed.count();
+}
+
+
+Stats measure(const std::string& path, std::size_t runs)
+{
+	runOnce(path); // Warm up the page cache
+
+	std::vector<double> times(runs);
+	for (auto& t : times)
+		t = runOnce(path);
+	std::sort(times.begin(), times.end());
+
+	const auto at = [&](double q)
+	{
+		return times[static_cast<std::size_t>(q * static_cast<double>(runs - 1))];
+	};
+
+	Stats stats{};
+	stats.name = path.substr(path.find_last_of('/') + 1);
+	stats.bytes = getFileSize(path);
+	stats.runs = runs;
+	stats.min = times.front();
+	stats.p50 = at(0.50);
+	stats.p90 = at(0.90);
+	stats.p99 = at(0.99);
+	stats.max = times.back();
+	return stats;
+}
+
+
+void writeCsv(std::ostream& out, const std::vector<Stats>& results)
+{
+	out << "name,bytes,runs,min_ns,p50_ns,p90_ns,p99_ns,max_ns,minarg_min_ns\n";
+	for (const auto& s : results)
+		out << s.name << ',' << s.bytes << ',' << s.runs
+			<< ',' << s.min << ',' << s.p50 << ',' << s.p90
+			<< ',' << s.p99 << ',' << s.max << ',' << s.share << '\n';
+}
+
+
+void writeJson(std::ostream& out, const std::vector<Stats>& results)
+{
+	out << "[\n";
+	for (std::size_t i{0}; i < results.size(); ++i)
+	{
+		const Stats& s{results[i]};
+		out << "  {\"name\": \"" << s.name
+			<< "\", \"bytes\": " << s.bytes
+			<< ", \"runs\": " << s.runs
+			<< ", \"min_ns\": " << s.min
+			<< ", \"p50_ns\": " << s.p50
+			<< ", \"p90_ns\": " << s.p90
+			<< ", \"p99_ns\": " << s.p99
+			<< ", \"max_ns\": " << s.max
+			<< ", \"minarg_min_ns\": " << s.share
+			<< (i + 1 < results.size() ? "},\n" : "}\n");
+	}
+	out << "]\n";
+}
+
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+	Format format{Format::csv};
+	std::size_t runs{200};
+	std::vector<std::string> utilities{};
+
+	minarg::Parser parser{"Measures the startup latency of minarg utilities"};
+	parser.addSignal('h', "help", "Show help and exit");
+	parser.addOption(format, 'f', "format", "FORMAT", "Output format",
+		{{"csv", Format::csv}, {"json", Format::json}});
+	parser.addOption(runs, 'r', "runs", "N", "Runs per utility");
+	parser.addOperandSink(utilities, "UTILITY", "Utility to run, the first is the baseline");
+
+	try {
+		parser.parse(argc, argv);
+		if (runs == 0)
+			throw minarg::Error{"Runs must be positive"};
+	}
+	catch (const minarg::Signal&) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (utilities.empty())
+		for (const char* name : {"none", "small", "medium", "large"})
+			utilities.push_back(std::string{MINARG_CLI_DIR} + "/minarg-cli-" + name);
+
+	std::vector<Stats> results{};
+	try {
+		for (const auto& utility : utilities)
+		{
+			results.push_back(measure(utility, runs));
+			results.back().share = std::max(0.0, results.back().min - results.front().min);
+		}
+	}
+	catch (const minarg::Error& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (format == Format::json)
+		writeJson(std::cout, results);
+	else
+		writeCsv(std::cout, results);
+}
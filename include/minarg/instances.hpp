@@ -0,0 +1,107 @@
+// Common template instances of the compiled minarg library
+// https://github.com/sevmeyer/minarg
+//
+// Copyright 2018 Severin Meyer
+// Licensed under the Boost Software License 1.0, see minarg.hpp
+
+
+#ifndef MINARG_INSTANCES_HPP_INCLUDED
+#define MINARG_INSTANCES_HPP_INCLUDED
+
+
+#include <minarg/minarg.hpp>
+
+
+// With MINARG_SEPARATE_COMPILATION, declares the instances as external,
+// which src/instances.cpp defines. Without MINARG_SEPARATE_COMPILATION,
+// this header declares nothing.
+//
+// The instances use the default minarg::Converter. To specialize it
+// for one of these types, define the matching MINARG_NO_INSTANCE_ macro,
+// e.g. MINARG_NO_INSTANCE_UNSIGNED_SHORT, in the whole program,
+// including the library. The type is then instantiated where it is used.
+// A specialization that is visible next to an instance fails to compile.
+
+#if defined(MINARG_SEPARATE_COMPILATION)
+
+#if defined(MINARG_INSTANCES_SOURCE)
+#define MINARG_EXTERN
+#else
+#define MINARG_EXTERN extern
+#endif
+
+namespace minarg {
+namespace detail {
+
+
+#define MINARG_INSTANTIATE_VALUE(T) \
+	static_assert(!HasParser<T>::value && !HasFormatter<T>::value, \
+		"minarg::Converter<" #T "> requires its MINARG_NO_INSTANCE_ macro"); \
+	MINARG_EXTERN template std::string toString<T>(const T&); \
+	MINARG_EXTERN template class ValueArg<T>; \
+	MINARG_EXTERN template class SinkArg<std::vector, T>;
+
+#define MINARG_INSTANTIATE_ARITHMETIC(T) \
+	MINARG_EXTERN template T fromString<T>(const std::string&); \
+	MINARG_INSTANTIATE_VALUE(T)
+
+// A single instance, if src/instances.cpp is compiled once per type
+#if defined(MINARG_INSTANCE)
+MINARG_INSTANCE
+#else
+#if !defined(MINARG_NO_INSTANCE_CHAR)
+MINARG_INSTANTIATE_ARITHMETIC(char)
+#endif
+#if !defined(MINARG_NO_INSTANCE_SIGNED_CHAR)
+MINARG_INSTANTIATE_ARITHMETIC(signed char)
+#endif
+#if !defined(MINARG_NO_INSTANCE_UNSIGNED_CHAR)
+MINARG_INSTANTIATE_ARITHMETIC(unsigned char)
+#endif
+#if !defined(MINARG_NO_INSTANCE_SHORT)
+MINARG_INSTANTIATE_ARITHMETIC(short)
+#endif
+#if !defined(MINARG_NO_INSTANCE_UNSIGNED_SHORT)
+MINARG_INSTANTIATE_ARITHMETIC(unsigned short)
+#endif
+#if !defined(MINARG_NO_INSTANCE_INT)
+MINARG_INSTANTIATE_ARITHMETIC(int)
+#endif
+#if !defined(MINARG_NO_INSTANCE_UNSIGNED_INT)
+MINARG_INSTANTIATE_ARITHMETIC(unsigned int)
+#endif
+#if !defined(MINARG_NO_INSTANCE_LONG)
+MINARG_INSTANTIATE_ARITHMETIC(long)
+#endif
+#if !defined(MINARG_NO_INSTANCE_UNSIGNED_LONG)
+MINARG_INSTANTIATE_ARITHMETIC(unsigned long)
+#endif
+#if !defined(MINARG_NO_INSTANCE_LONG_LONG)
+MINARG_INSTANTIATE_ARITHMETIC(long long)
+#endif
+#if !defined(MINARG_NO_INSTANCE_UNSIGNED_LONG_LONG)
+MINARG_INSTANTIATE_ARITHMETIC(unsigned long long)
+#endif
+#if !defined(MINARG_NO_INSTANCE_FLOAT)
+MINARG_INSTANTIATE_ARITHMETIC(float)
+#endif
+#if !defined(MINARG_NO_INSTANCE_DOUBLE)
+MINARG_INSTANTIATE_ARITHMETIC(double)
+#endif
+#if !defined(MINARG_NO_INSTANCE_STRING)
+MINARG_INSTANTIATE_VALUE(std::string)
+#endif
+#endif
+
+#undef MINARG_INSTANTIATE_ARITHMETIC
+#undef MINARG_INSTANTIATE_VALUE
+
+
+} // namespace detail
+} // namespace minarg
+
+#undef MINARG_EXTERN
+
+#endif
+
+#endif // MINARG_INSTANCES_HPP_INCLUDED
@@ -1,4 +1,4 @@
-// minarg 1.0.1
+// minarg 2.0.0
 // A minimalist argument parsing library for C++11
 // https://github.com/sevmeyer/minarg
 //
@@ -32,39 +32,228 @@
 #define MINARG_MINARG_HPP_INCLUDED
 
 
+#include <cassert>
+#include <cctype>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <exception>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <locale>
+#include <map>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 
+// Separate compilation declares the out-of-line definitions,
+// which src/minarg.cpp defines
+#if !defined(MINARG_SEPARATE_COMPILATION)
+#define MINARG_DECL inline
+#else
+#define MINARG_DECL
+#endif
+
+
 namespace minarg {
+
+
+// ---- Custom conversion ----
+
+// Specialize for custom value types, to bypass the stream operators:
+//
+// template<>
+// struct Converter<T>
+// {
+//   // Returns false if the characters in [first, last) are invalid
+//   static bool parse(const char* first, const char* last, T& value);
+//
+//   // Optional, formats the default value for the help message
+//   static std::string format(const T& value);
+// };
+
+template<typename T>
+struct Converter
+{};
+
+
 namespace detail {
 
 
+// ---- Choice names ----
+
+// Names of the choices of an option, sorted for binary search.
+// Shared with the errors of the option, which only join
+// the names when their message is formatted.
+struct ChoiceNames
+{
+	std::vector<std::string> sorted{};
+
+	// Positions in sorted, in the given order of the choices
+	std::vector<std::size_t> order{};
+
+	std::string join() const
+	{
+		std::string s{};
+		for (std::size_t i : order)
+			s += (s.empty() ? "" : ", ") + sorted[i];
+		return s;
+	}
+};
+
+
 // ---- Exceptions ----
 
 struct Error : public std::exception
 {
-	const std::string message;
+	enum class Kind
+	{
+		custom,
+		invalidInteger,
+		invalidUnsigned,
+		invalidValue,
+		unclosedQuote,
+		missingEscaped,
+		missingValue,
+		missingArgument,
+		unexpectedValue,
+		unexpectedOption,
+		unexpectedArgument,
+		unknownOption,
+		ambiguousOption,
+		invalidChoice
+	};
+
+	const Kind kind;
+
+	// Offending token, option name, or argument name
+	const std::string argument;
+
+	// Suggested or ambiguous option names
+	const std::vector<std::string> candidates;
+
+	// Position of the offending argument in argv, or
+	// argc if the error is not tied to a single argument
+	std::size_t index{0};
 
 	Error(std::string message) :
-		message{std::move(message)}
+		kind{Kind::custom},
+		argument{},
+		candidates{},
+		message_{new std::string(std::move(message))}
 	{}
 
+	Error(Kind kind, std::string argument, std::vector<std::string> candidates={}) :
+		kind{kind},
+		argument{std::move(argument)},
+		candidates{std::move(candidates)}
+	{}
+
+	// Invalid choice, the expected names are only copied into the message
+	Error(std::string argument, std::shared_ptr<const ChoiceNames> choices) :
+		kind{Kind::invalidChoice},
+		argument{std::move(argument)},
+		candidates{},
+		choices_{std::move(choices)}
+	{}
+
+	Error(const Error& other) :
+		std::exception{other},
+		kind{other.kind},
+		argument{other.argument},
+		candidates{other.candidates},
+		index{other.index},
+		choices_{other.choices_},
+		message_{copyMessage(other)}
+	{}
+
+	Error& operator=(const Error&) = delete;
+
+	~Error() noexcept override
+	{
+		delete message_.load(std::memory_order_acquire);
+	}
+
+	// The message is only formatted when it is first requested.
+	// The first formatted message is published atomically, so
+	// what() may be called concurrently on the same error.
 	const char* what() const noexcept override
 	{
-		return message.c_str();
+		const std::string* message{message_.load(std::memory_order_acquire)};
+		if (message == nullptr)
+		{
+			try
+			{
+				std::unique_ptr<const std::string> formatted{new std::string(formatMessage())};
+				if (message_.compare_exchange_strong(message, formatted.get(),
+					std::memory_order_acq_rel, std::memory_order_acquire))
+					message = formatted.release();
+			}
+			catch (...)
+			{
+				return "minarg::Error";
+			}
+		}
+		return message->c_str();
 	}
+
+	private:
+
+		std::shared_ptr<const ChoiceNames> choices_{};
+
+		// Owned, null until formatted
+		mutable std::atomic<const std::string*> message_{nullptr};
+
+		// A formatted message is copied, an unformatted one stays lazy
+		static const std::string* copyMessage(const Error& other)
+		{
+			const std::string* message{other.message_.load(std::memory_order_acquire)};
+			return message == nullptr ? nullptr : new std::string(*message);
+		}
+
+		std::string formatMessage() const
+		{
+			switch (kind)
+			{
+				case Kind::custom:             return {};
+				case Kind::invalidInteger:     return "Cannot parse integer: " + argument;
+				case Kind::invalidUnsigned:    return "Cannot parse unsigned integer: " + argument;
+				case Kind::invalidValue:       return "Cannot parse value: " + argument;
+				case Kind::unclosedQuote:      return "Cannot find closing quote: " + argument;
+				case Kind::missingEscaped:     return "Cannot find escaped character: " + argument;
+				case Kind::missingValue:       return "Cannot find value for option: " + argument;
+				case Kind::missingArgument:    return "Cannot find required argument: " + argument;
+				case Kind::unexpectedValue:    return "Unexpected option value: " + argument;
+				case Kind::unexpectedOption:   return "Unexpected option: " + argument;
+				case Kind::unexpectedArgument: return "Unexpected argument: " + argument;
+				case Kind::unknownOption:
+					return "Unknown option name: " + argument +
+						(candidates.empty() ? "" : " (did you mean " + joinCandidates() + "?)");
+				case Kind::ambiguousOption:
+					return "Ambiguous option name: " + argument + " (" + joinCandidates() + ")";
+				case Kind::invalidChoice:
+					return "Cannot parse choice: " + argument +
+						" (expected " + (choices_ ? choices_->join() : joinCandidates()) + ")";
+			}
+			return {};
+		}
+
+		std::string joinCandidates() const
+		{
+			std::string s{};
+			for (const auto& candidate : candidates)
+				s += (s.empty() ? "" : ", ") + candidate;
+			return s;
+		}
 };
 
 
@@ -80,6 +269,173 @@ struct Signal : public std::exception
 };
 
 
+// ---- Observer ----
+
+// Receives events during parsing, e.g. for metrics.
+// All events are optional and do nothing by default.
+class Observer
+{
+	public:
+
+		enum class Phase
+		{
+			setup,
+			utility,
+			options,
+			operands,
+			checks,
+			done
+		};
+
+		virtual ~Observer() = default;
+
+		// Start of a phase, which ends at the start of the next
+		virtual void onPhase(Phase) {}
+
+		// Option or operand token, excluding separate option values,
+		// as the characters in [first, last)
+		virtual void onToken(const char* /*first*/, const char* /*last*/) {}
+
+		// Option name lookup, successful or not
+		virtual void onLookup() {}
+
+		// Successful lookup
+		virtual void onOption(char /*shortName*/, const std::string& /*longName*/) {}
+
+		// Option value or operand, before its conversion
+		virtual void onConversion(const std::string&) {}
+
+		// Thrown or collected error
+		virtual void onError(const Error&) {}
+};
+
+
+// Counts the events of all parses
+class Counters : public Observer
+{
+	public:
+
+		std::size_t getTokens()      const { return tokens_;      }
+		std::size_t getLookups()     const { return lookups_;     }
+		std::size_t getConversions() const { return conversions_; }
+
+		std::size_t getErrors() const
+		{
+			std::size_t sum{0};
+			for (const auto& errors : errors_)
+				sum += errors.second;
+			return sum;
+		}
+
+		std::size_t getErrors(Error::Kind kind) const
+		{
+			auto it{errors_.find(kind)};
+			return it == errors_.end() ? 0 : it->second;
+		}
+
+		// Options by long name, or by short name if there is no long name
+		const std::map<std::string, std::size_t>& getHits() const
+		{
+			return hits_;
+		}
+
+		void clear()
+		{
+			*this = Counters{};
+		}
+
+		void onToken(const char*, const char*) override { ++tokens_;      }
+		void onLookup()                        override { ++lookups_;     }
+		void onConversion(const std::string&)  override { ++conversions_; }
+
+		void onOption(char shortName, const std::string& longName) override
+		{
+			if (!longName.empty())
+				++hits_[longName];
+			else
+				++hits_[std::string{shortName}];
+		}
+
+		void onError(const Error& error) override
+		{
+			++errors_[error.kind];
+		}
+
+	private:
+
+		std::size_t tokens_{0};
+		std::size_t lookups_{0};
+		std::size_t conversions_{0};
+		// Independent of the number of kinds
+		std::map<Error::Kind, std::size_t> errors_{};
+		std::map<std::string, std::size_t> hits_{};
+};
+
+
+// ---- Conversion streams ----
+
+// Constructing a stream copies the global locale, which is guarded
+// by a lock. Each thread therefore reuses its own pair of streams,
+// imbued with the classic locale. Conversions must not be nested.
+
+template<typename Stream>
+Stream makeStream()
+{
+	Stream stream{};
+	stream.imbue(std::locale::classic());
+	return stream;
+}
+
+
+template<typename Stream>
+void resetStream(Stream& stream)
+{
+	stream.clear();
+	stream.flags(std::ios_base::skipws | std::ios_base::dec);
+	stream.precision(6);
+	stream.width(0);
+	stream.fill(' ');
+}
+
+
+inline std::istringstream& getInputStream(const std::string& s)
+{
+	thread_local std::istringstream stream{makeStream<std::istringstream>()};
+	resetStream(stream);
+	stream.str(s);
+	return stream;
+}
+
+
+inline std::ostringstream& getOutputStream()
+{
+	thread_local std::ostringstream stream{makeStream<std::ostringstream>()};
+	resetStream(stream);
+	stream.str({});
+	return stream;
+}
+
+
+// ---- Converter detection ----
+
+template<typename T, typename = void>
+struct HasParser : std::false_type {};
+
+template<typename T>
+struct HasParser<T, decltype(void(Converter<T>::parse(
+	std::declval<const char*>(),
+	std::declval<const char*>(),
+	std::declval<T&>())))> : std::true_type {};
+
+
+template<typename T, typename = void>
+struct HasFormatter : std::false_type {};
+
+template<typename T>
+struct HasFormatter<T, decltype(void(Converter<T>::format(
+	std::declval<const T&>())))> : std::true_type {};
+
+
 // ---- String to value ----
 
 // Prepare signed integer
@@ -99,14 +455,26 @@ toLongest(const std::string& s, std::size_t* pos, int base)
 	// Detect underflow, otherwise stoull wraps around
 	// negative values instead of reporting an error
 	if (s.find('-') != std::string::npos)
-		throw Error{"Cannot parse unsigned integer: " + s};
+		throw Error{Error::Kind::invalidUnsigned, s};
 	return std::stoull(s, pos, base);
 }
 
 
+// Read with custom converter
+template<typename T>
+typename std::enable_if<HasParser<T>::value, T>::type
+fromString(const std::string& s)
+{
+	T value{};
+	if (!Converter<T>::parse(s.data(), s.data() + s.size(), value))
+		throw Error{Error::Kind::invalidValue, s};
+	return value;
+}
+
+
 // Read integer
 template<typename T>
-typename std::enable_if<std::is_integral<T>::value, T>::type
+typename std::enable_if<!HasParser<T>::value && std::is_integral<T>::value, T>::type
 fromString(const std::string& s)
 {
 	try
@@ -121,30 +489,36 @@ fromString(const std::string& s)
 	}
 	catch(const std::invalid_argument&) {}
 	catch(const std::out_of_range&) {}
-	throw Error{"Cannot parse integer: " + s};
+	throw Error{Error::Kind::invalidInteger, s};
 }
 
 
 // Read non-integer
 template<typename T>
-typename std::enable_if<!std::is_integral<T>::value, T>::type
+typename std::enable_if<!HasParser<T>::value && !std::is_integral<T>::value
+	&& !std::is_same<T, std::string>::value, T>::type
 fromString(const std::string& s)
 {
 	T value{};
-	std::stringstream stream{s};
-	stream >> value >> std::ws;
+	std::istringstream& stream{getInputStream(s)};
+	stream >> value;
+
+	// Skipping whitespace at the end would set the failbit
+	if (!stream.fail() && !stream.eof())
+		stream >> std::ws;
 
 	if (stream.fail() || !stream.eof())
-		throw Error{"Cannot parse value: " + s};
+		throw Error{Error::Kind::invalidValue, s};
 
 	return value;
 }
 
 
-// Read string
-template<>
-inline std::string
-fromString<std::string>(const std::string& s)
+// Read string, an overload instead of a specialization,
+// so that Converter<std::string> can still be specialized
+template<typename T>
+typename std::enable_if<!HasParser<T>::value && std::is_same<T, std::string>::value, T>::type
+fromString(const std::string& s)
 {
 	return s;
 }
@@ -178,16 +552,326 @@ toStream(std::ostream& stream, const T& value)
 }
 
 
+// Create string with custom converter
+template<typename T>
+typename std::enable_if<HasFormatter<T>::value, std::string>::type
+toString(const T& value)
+{
+	return Converter<T>::format(value);
+}
+
+
 // Create string
 template<typename T>
-std::string toString(const T& value)
+typename std::enable_if<!HasFormatter<T>::value, std::string>::type
+toString(const T& value)
 {
-	std::stringstream stream{};
+	std::ostringstream& stream{getOutputStream()};
 	toStream<T>(stream, value);
 	return stream.str();
 }
 
 
+// ---- Tokens ----
+
+// View of an argument, which points into argv, into a string of the
+// argument vector, or into a command line. Only values are copied,
+// into a reused buffer, when they are converted.
+struct Token
+{
+	const char* first;
+	const char* last;
+
+	const char* begin() const { return first; }
+	const char* end()   const { return last;  }
+
+	std::size_t size() const { return static_cast<std::size_t>(last - first); }
+	char front() const { return *first; }
+
+	std::string str() const { return {first, last}; }
+
+	bool operator==(const std::string& s) const
+	{
+		return size() == s.size() && std::equal(first, last, s.begin());
+	}
+
+	bool operator!=(const std::string& s) const
+	{
+		return !(*this == s);
+	}
+
+	bool startsWith(const std::string& s) const
+	{
+		return size() >= s.size() && std::equal(s.begin(), s.end(), first);
+	}
+};
+
+
+// ---- Command line ----
+
+// Split a command line into arguments, like a POSIX shell.
+// Supports single quotes, double quotes, and backslash escapes,
+// but no expansions, operators, or comments. Plain words are
+// views into the line. Words with quotes or escapes are unquoted
+// into the buffer, which never grows beyond the size of the line,
+// so that its views stay valid. Errors carry the rest of the line
+// from the start of the offending word.
+inline void splitCommandLine(const std::string& line, std::string& buffer, std::vector<Token>& tokens)
+{
+	const auto isBlank = [](char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n';
+	};
+
+	const auto isSpecial = [](char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n'
+			|| c == '\'' || c == '\"' || c == '\\';
+	};
+
+	tokens.clear();
+	buffer.clear();
+	buffer.reserve(line.size());
+
+	const char* it{line.data()};
+	const char* const end{it + line.size()};
+
+	while (true)
+	{
+		it = std::find_if_not(it, end, isBlank);
+		if (it == end)
+			break;
+
+		// Plain words are not copied
+		const char* start{it};
+		it = std::find_if(it, end, isSpecial);
+		if (it == end || isBlank(*it))
+		{
+			tokens.push_back(Token{start, it});
+			continue;
+		}
+
+		const std::size_t first{buffer.size()};
+		buffer.append(start, it);
+		bool isQuoted{false};
+
+		while (it != end && !isBlank(*it))
+		{
+			if (*it == '\'')
+			{
+				const char* close{std::find(it + 1, end, '\'')};
+				if (close == end)
+					throw Error{Error::Kind::unclosedQuote, std::string{start, end}};
+
+				buffer.append(it + 1, close);
+				it = close + 1;
+				isQuoted = true;
+			}
+			else if (*it == '\"')
+			{
+				++it;
+				while (true)
+				{
+					const char* stop{std::find_if(it, end,
+						[](char c) { return c == '\"' || c == '\\'; })};
+					buffer.append(it, stop);
+					it = stop;
+
+					if (it == end)
+						throw Error{Error::Kind::unclosedQuote, std::string{start, end}};
+
+					if (*it++ == '\"')
+						break;
+
+					if (it == end)
+						throw Error{Error::Kind::unclosedQuote, std::string{start, end}};
+
+					// Backslash only escapes these characters
+					if (*it == '\n')
+						++it;
+					else if (*it == '$' || *it == '`' || *it == '\"' || *it == '\\')
+						buffer += *it++;
+					else
+						buffer += '\\';
+				}
+				isQuoted = true;
+			}
+			else if (*it == '\\')
+			{
+				if (++it == end)
+					throw Error{Error::Kind::missingEscaped, std::string{start, end}};
+
+				// Escaped newline continues the line
+				if (*it != '\n')
+					buffer += *it;
+				++it;
+			}
+			else
+			{
+				const char* stop{std::find_if(it, end, isSpecial)};
+				buffer.append(it, stop);
+				it = stop;
+			}
+		}
+
+		if (isQuoted || buffer.size() > first)
+			tokens.push_back(Token{buffer.data() + first, buffer.data() + buffer.size()});
+	}
+}
+
+
+// ---- Container capacity ----
+
+// Sequence with capacity, grow geometrically,
+// even if single values are reserved exactly
+template<typename C>
+auto reserveMore(C& c, std::size_t n, int)
+	-> decltype(c.reserve(n), c.capacity(), void())
+{
+	if (c.capacity() - c.size() < n)
+		c.reserve(std::max(c.size() + n, c.capacity()*2));
+}
+
+
+// Hash map, reserve buckets
+template<typename C>
+auto reserveMore(C& c, std::size_t n, long)
+	-> decltype(c.reserve(n), void())
+{
+	c.reserve(c.size() + n);
+}
+
+
+// No reservation possible
+template<typename C>
+void reserveMore(C&, std::size_t, ...)
+{}
+
+
+// ---- Memory footprint ----
+
+// Bytes held by a parser, by category
+struct Footprint
+{
+	std::size_t parser{0};    // Parser object
+	std::size_t arguments{0}; // Argument objects and their pointers
+	std::size_t names{0};     // Heap storage of names, descriptions, and help texts
+	std::size_t defaults{0};  // Saved default values
+	std::size_t choices{0};   // Choice tables
+	std::size_t index{0};     // Heap storage of the short and long name tables
+	std::size_t buffers{0};   // Heap storage reused by each parse
+
+	std::size_t getTotal() const
+	{
+		return parser + arguments + names + defaults + choices + index + buffers;
+	}
+};
+
+
+// Zero if the characters are stored inline, which is the case
+// as long as the capacity fits that of an empty string
+inline std::size_t heapSize(const std::string& s)
+{
+	static const std::size_t inlineCapacity{std::string{}.capacity()};
+	return s.capacity() <= inlineCapacity ? 0 : s.capacity() + 1;
+}
+
+
+// Excludes the heap storage of the elements
+template<typename T>
+std::size_t heapSize(const std::vector<T>& v)
+{
+	return v.capacity() * sizeof(T);
+}
+
+
+// Other types are only counted by their size
+template<typename T>
+std::size_t heapSize(const T&)
+{
+	return 0;
+}
+
+
+// ---- Default values ----
+
+// Values are saved only when the target is overwritten for the first time,
+// into a record that is shared by all arguments with the same target.
+// Until then, the default is the current value of the target.
+
+
+// Identifies the type of a shared default
+template<typename T>
+struct TypeTag
+{
+	static const char id;
+};
+
+template<typename T>
+const char TypeTag<T>::id{0};
+
+
+class SharedDefault
+{
+	public:
+
+		virtual ~SharedDefault() noexcept = default;
+
+		virtual std::size_t getSize() const = 0;
+};
+
+
+template<typename T>
+class SavedValue : public SharedDefault
+{
+	public:
+
+		T value{};
+		bool isSaved{false};
+
+		std::size_t getSize() const override
+		{
+			return sizeof(*this) + heapSize(value);
+		}
+};
+
+
+template<typename T>
+class DefaultValue
+{
+	public:
+
+		DefaultValue(T& target, std::shared_ptr<SavedValue<T>> saved) :
+			target_{target},
+			saved_{std::move(saved)}
+		{}
+
+		// Called before the target is overwritten. Copies the value
+		// if the target can keep its capacity, otherwise moves it.
+		void save(bool isCopied)
+		{
+			if (saved_->isSaved)
+				return;
+
+			if (isCopied)
+				saved_->value = target_;
+			else
+				saved_->value = std::move(target_);
+			saved_->isSaved = true;
+		}
+
+		const T& get() const
+		{
+			return saved_->isSaved ? saved_->value : target_;
+		}
+
+	private:
+
+		T& target_;
+		std::shared_ptr<SavedValue<T>> saved_;
+};
+
+
 // ---- Polymorphic argument types ----
 
 class Arg
@@ -218,11 +902,47 @@ class Arg
 			isDone_ = true;
 		}
 
+		void reset()
+		{
+			isDone_ = false;
+		}
+
+		// Counts an expected value, before the parse
+		void expect()
+		{
+			++expected_;
+		}
+
+		// Prepares for the expected values
+		void reserve()
+		{
+			if (expected_ > 0)
+				doReserve(expected_);
+			expected_ = 0;
+		}
+
 		std::string getDefaultValue() const
 		{
 			return isRequired_ ? std::string{} : doGetDefaultValue();
 		}
 
+		std::vector<std::string> getChoices() const
+		{
+			return doGetChoices();
+		}
+
+		void addFootprint(Footprint& f) const
+		{
+			f.names += heapSize(longName_) + heapSize(valueName_) + heapSize(description_);
+			doAddFootprint(f);
+		}
+
+		// Releases spare capacity
+		void shrink()
+		{
+			doShrink();
+		}
+
 	protected:
 
 		Arg(char shortName,
@@ -243,7 +963,11 @@ class Arg
 
 		virtual void doParse(const std::string&) {}
 		virtual void doDone() {}
+		virtual void doReserve(std::size_t) {}
 		virtual std::string doGetDefaultValue() const { return {}; }
+		virtual std::vector<std::string> doGetChoices() const { return {}; }
+		virtual void doAddFootprint(Footprint& f) const = 0;
+		virtual void doShrink() {}
 
 	private:
 
@@ -256,6 +980,7 @@ class Arg
 		const bool hasValue_;
 		const bool isSink_;
 		bool isDone_{false};
+		std::size_t expected_{0};
 };
 
 
@@ -279,6 +1004,11 @@ class SignalArg : public Arg
 		{
 			throw Signal{getShortName(), getLongName()};
 		}
+
+		void doAddFootprint(Footprint& f) const override
+		{
+			f.arguments += sizeof(*this);
+		}
 };
 
 
@@ -306,6 +1036,11 @@ class BoolArg : public Arg
 			target_ = true;
 		}
 
+		void doAddFootprint(Footprint& f) const override
+		{
+			f.arguments += sizeof(*this);
+		}
+
 	private:
 
 		bool& target_;
@@ -322,32 +1057,57 @@ class ValueArg : public Arg
 			std::string valueName,
 			std::string description,
 			bool isRequired,
-			T& target) :
+			T& target,
+			DefaultValue<T> defaultValue) :
 				Arg{shortName,
 					std::move(longName),
 					std::move(valueName),
 					std::move(description),
 					isRequired, true, false},
 				target_{target},
-				default_{target}
+				default_{std::move(defaultValue)}
 		{}
 
 	protected:
 
 		void doParse(const std::string& s) override
 		{
-			target_ = fromString<T>(s);
+			assign(s);
 		}
 
 		std::string doGetDefaultValue() const override
 		{
-			return toString<T>(default_);
+			return toString<T>(default_.get());
+		}
+
+		void doAddFootprint(Footprint& f) const override
+		{
+			f.arguments += sizeof(*this) - sizeof(default_);
+			f.defaults += sizeof(default_);
 		}
 
 	private:
 
 		T& target_;
-		const T default_;
+		DefaultValue<T> default_;
+
+		// Assign string in place, to reuse the capacity of the target
+		template<typename U = T>
+		typename std::enable_if<std::is_same<U, std::string>::value && !HasParser<U>::value>::type
+		assign(const std::string& s)
+		{
+			default_.save(s.size() <= target_.capacity());
+			target_.assign(s);
+		}
+
+		template<typename U = T>
+		typename std::enable_if<!std::is_same<U, std::string>::value || HasParser<U>::value>::type
+		assign(const std::string& s)
+		{
+			T value{fromString<T>(s)};
+			default_.save(false);
+			target_ = std::move(value);
+		}
 };
 
 
@@ -356,16 +1116,19 @@ class SinkArg : public Arg
 {
 	public:
 
-		SinkArg(
+		SinkArg(char shortName,
+			std::string longName,
 			std::string valueName,
 			std::string description,
 			bool isRequired,
+			char delimiter,
 			Container<T>& target) :
-				Arg{0,
-					{},
+				Arg{shortName,
+					std::move(longName),
 					std::move(valueName),
 					std::move(description),
 					isRequired, true, true},
+				delimiter_{delimiter},
 				target_{target}
 		{}
 
@@ -373,12 +1136,400 @@ class SinkArg : public Arg
 
 		void doParse(const std::string& s) override
 		{
-			target_.push_back(fromString<T>(s));
+			if (delimiter_ == 0)
+			{
+				target_.push_back(fromString<T>(s));
+				return;
+			}
+
+			reserveMore(target_, std::count(s.begin(), s.end(), delimiter_) + 1, 0);
+
+			std::string::size_type first{0};
+			while (true)
+			{
+				auto last{s.find(delimiter_, first)};
+				element_.assign(s, first, last - first);
+				target_.push_back(fromString<T>(element_));
+
+				if (last == std::string::npos)
+					break;
+				first = last + 1;
+			}
+		}
+
+		void doAddFootprint(Footprint& f) const override
+		{
+			f.arguments += sizeof(*this);
+			f.buffers += heapSize(element_);
 		}
 
 	private:
 
+		const char delimiter_;
 		Container<T>& target_;
+
+		// Reused for each element of a delimited list
+		std::string element_{};
+};
+
+
+template<typename Map>
+class MapArg : public Arg
+{
+	using Key = typename Map::key_type;
+	using Mapped = typename Map::mapped_type;
+
+	public:
+
+		MapArg(char shortName,
+			std::string longName,
+			std::string valueName,
+			std::string description,
+			bool isRequired,
+			char separator,
+			Map& target) :
+				Arg{shortName,
+					std::move(longName),
+					std::move(valueName),
+					std::move(description),
+					isRequired, true, true},
+				separator_{separator},
+				target_{target}
+		{}
+
+	protected:
+
+		// Later values overwrite earlier values with the same key
+		void doParse(const std::string& s) override
+		{
+			auto sep{s.find(separator_)};
+			if (sep == std::string::npos)
+				throw Error{Error::Kind::invalidValue, s};
+
+			key_.assign(s, 0, sep);
+			value_.assign(s, sep + 1, std::string::npos);
+
+			Key key{fromString<Key>(key_)};
+			Mapped value{fromString<Mapped>(value_)};
+			target_[std::move(key)] = std::move(value);
+		}
+
+		void doReserve(std::size_t n) override
+		{
+			reserveMore(target_, n, 0);
+		}
+
+		void doAddFootprint(Footprint& f) const override
+		{
+			f.arguments += sizeof(*this);
+			f.buffers += heapSize(key_) + heapSize(value_);
+		}
+
+	private:
+
+		const char separator_;
+		Map& target_;
+
+		// Reused for each key and value
+		std::string key_{};
+		std::string value_{};
+};
+
+
+template<typename T>
+class ChoiceArg : public Arg
+{
+	using Choice = std::pair<std::string, T>;
+
+	public:
+
+		ChoiceArg(char shortName,
+			std::string longName,
+			std::string valueName,
+			std::string description,
+			bool isRequired,
+			std::vector<Choice> choices,
+			T& target,
+			DefaultValue<T> defaultValue) :
+				Arg{shortName,
+					std::move(longName),
+					std::move(valueName),
+					std::move(description),
+					isRequired, true, false},
+				target_{target},
+				default_{std::move(defaultValue)}
+		{
+			// Sorted for binary search, the first duplicate takes precedence
+			std::vector<std::size_t> positions(choices.size());
+			for (std::size_t i{0}; i < positions.size(); ++i)
+				positions[i] = i;
+			std::stable_sort(positions.begin(), positions.end(),
+				[&](std::size_t a, std::size_t b) { return choices[a].first < choices[b].first; });
+
+			names_->order.resize(choices.size());
+			for (std::size_t i : positions)
+			{
+				names_->order[i] = names_->sorted.size();
+				names_->sorted.push_back(std::move(choices[i].first));
+				values_.push_back(std::move(choices[i].second));
+			}
+		}
+
+	protected:
+
+		void doParse(const std::string& s) override
+		{
+			const std::vector<std::string>& sorted{names_->sorted};
+			auto it{std::lower_bound(sorted.begin(), sorted.end(), s)};
+
+			if (it == sorted.end() || *it != s)
+				throw Error{s, names_};
+
+			default_.save(false);
+			target_ = values_[static_cast<std::size_t>(it - sorted.begin())];
+		}
+
+		std::string doGetDefaultValue() const override
+		{
+			const T& value{default_.get()};
+			for (std::size_t i{0}; i < values_.size(); ++i)
+				if (values_[i] == value)
+					return names_->sorted[i];
+			return {};
+		}
+
+		std::vector<std::string> doGetChoices() const override
+		{
+			std::vector<std::string> choices{};
+			for (std::size_t i : names_->order)
+				choices.push_back(names_->sorted[i]);
+			return choices;
+		}
+
+		void doAddFootprint(Footprint& f) const override
+		{
+			f.arguments += sizeof(*this) - sizeof(default_);
+			f.defaults += sizeof(default_);
+
+			f.choices += sizeof(ChoiceNames) + heapSize(names_->sorted)
+				+ heapSize(names_->order) + heapSize(values_);
+			for (const auto& name : names_->sorted)
+				f.choices += heapSize(name);
+			for (const auto& value : values_)
+				f.choices += heapSize(value);
+		}
+
+		void doShrink() override
+		{
+			names_->sorted.shrink_to_fit();
+			names_->order.shrink_to_fit();
+			values_.shrink_to_fit();
+		}
+
+	private:
+
+		T& target_;
+		DefaultValue<T> default_;
+
+		// Values in the order of the sorted names
+		std::shared_ptr<ChoiceNames> names_{std::make_shared<ChoiceNames>()};
+		std::vector<T> values_{};
+};
+
+
+// ---- Edit distance ----
+
+// Computes the Levenshtein distance to a fixed pattern with the
+// bit-parallel algorithm by Myers, in the formulation by Hyyrö.
+// The text is consumed one char at a time, so that texts with
+// a shared prefix can continue from the same state.
+class EditDistance
+{
+	public:
+
+		// Vertical deltas of the current column, and the distance
+		// of the whole pattern to the text consumed so far
+		struct State
+		{
+			std::uint64_t pv;
+			std::uint64_t mv;
+			std::size_t score;
+			std::size_t length;
+		};
+
+		// The pattern must not be empty or longer than 64 chars
+		explicit EditDistance(const std::string& pattern) :
+			size_{pattern.size()}
+		{
+			std::uint64_t bit{1};
+			for (char c : pattern)
+			{
+				peq_[static_cast<unsigned char>(c)] |= bit;
+				bit <<= 1;
+			}
+		}
+
+		State start() const
+		{
+			return {~std::uint64_t{0}, 0, size_, 0};
+		}
+
+		State step(const State& s, char c) const
+		{
+			const std::uint64_t last{std::uint64_t{1} << (size_ - 1)};
+			const std::uint64_t eq{peq_[static_cast<unsigned char>(c)]};
+			const std::uint64_t xv{eq | s.mv};
+			const std::uint64_t xh{(((eq & s.pv) + s.pv) ^ s.pv) | eq};
+			std::uint64_t ph{s.mv | ~(xh | s.pv)};
+			std::uint64_t mh{s.pv & xh};
+
+			std::size_t score{s.score};
+			if (ph & last)
+				++score;
+			else if (mh & last)
+				--score;
+
+			ph = (ph << 1) | 1;
+			mh <<= 1;
+			return {mh | ~(xv | ph), ph & xv, score, s.length + 1};
+		}
+
+		// Early cutoff: whether any continuation of the text can be within
+		// the distance, i.e. whether any prefix of the pattern is within it
+		bool isReachable(const State& s, std::size_t maxDistance) const
+		{
+			if (s.score <= maxDistance)
+				return true;
+
+			std::size_t d{s.length};
+			for (std::size_t i{0}; d > maxDistance && i < size_; ++i)
+				d = d + ((s.pv >> i) & 1) - ((s.mv >> i) & 1);
+			return d <= maxDistance;
+		}
+
+	private:
+
+		std::array<std::uint64_t, 256> peq_{};
+		const std::size_t size_;
+};
+
+
+// ---- Option index ----
+
+// Resolves option names. Short names are looked up in a table, long
+// names with a single hashed lookup. The long names are also sorted,
+// so that names with a shared prefix are adjacent, which serves the
+// abbreviations and the suggestions. The short name table is only
+// allocated once there is a short name.
+class OptionIndex
+{
+	using StringIt = const char*;
+	using Entry = std::pair<std::string, Arg*>;
+
+	public:
+
+		void clear()
+		{
+			shortNames_.clear();
+			longNames_.clear();
+			slots_.clear();
+		}
+
+		// The first argument with a given name takes precedence
+		void insert(Arg* arg)
+		{
+			const unsigned char shortName{static_cast<unsigned char>(arg->getShortName())};
+			if (shortName != 0)
+			{
+				if (shortNames_.empty())
+					shortNames_.assign(256, nullptr);
+				if (shortNames_[shortName] == nullptr)
+					shortNames_[shortName] = arg;
+			}
+
+			if (!arg->getLongName().empty())
+				longNames_.emplace_back(arg->getLongName(), arg);
+		}
+
+		// Sorts and hashes the long names, after all arguments are inserted
+		void build();
+
+		Arg* findShort(char name) const
+		{
+			return shortNames_.empty() ? nullptr : shortNames_[static_cast<unsigned char>(name)];
+		}
+
+		void addFootprint(Footprint& f) const
+		{
+			f.index += heapSize(shortNames_) + heapSize(longNames_) + heapSize(slots_);
+			for (const Entry& e : longNames_)
+				f.index += heapSize(e.first);
+		}
+
+		void shrink()
+		{
+			shortNames_.shrink_to_fit();
+			longNames_.shrink_to_fit();
+			slots_.shrink_to_fit();
+		}
+
+		// Advances it to the separator or the end of the token. An exact
+		// match takes precedence over an unambiguous abbreviation.
+		Arg* findLong(StringIt& it, StringIt end, char separator, bool isAbbreviated) const;
+
+		// Returns the arguments whose long names have the smallest edit
+		// distance to the name, and lowers maxDistance to it. Shared prefixes
+		// of adjacent names are compared once, and the names after a prefix
+		// that cannot come close are skipped.
+		std::vector<const Arg*> findClosest(const std::string& name, std::size_t& maxDistance) const;
+
+		// Returns all arguments with a long name that starts with the prefix
+		std::vector<const Arg*> findAbbreviated(StringIt first, StringIt last) const;
+
+	private:
+
+		std::vector<Arg*> shortNames_{};
+		std::vector<Entry> longNames_{};
+
+		// Open addressing table of positions in longNames_,
+		// plus one, because zero marks an empty slot
+		std::vector<std::size_t> slots_{};
+
+		// FNV-1a
+		static constexpr std::size_t hashBasis{2166136261u};
+
+		static std::size_t hashStep(std::size_t h, char c)
+		{
+			return (h ^ static_cast<unsigned char>(c)) * 16777619u;
+		}
+
+		static std::size_t hash(StringIt first, StringIt last)
+		{
+			std::size_t h{hashBasis};
+			for (; first != last; ++first)
+				h = hashStep(h, *first);
+			return h;
+		}
+
+		// First name that is not less than the characters in [first, last)
+		std::vector<Entry>::const_iterator lowerBound(StringIt first, StringIt last) const
+		{
+			const std::size_t size{static_cast<std::size_t>(last - first)};
+			return std::lower_bound(longNames_.begin(), longNames_.end(), size,
+				[first](const Entry& e, std::size_t n)
+				{
+					const int order{std::char_traits<char>::compare(
+						e.first.data(), first, std::min(e.first.size(), n))};
+					return order < 0 || (order == 0 && e.first.size() < n);
+				});
+		}
+
+		static bool startsWith(const Entry& e, StringIt first, StringIt last)
+		{
+			const std::size_t size{static_cast<std::size_t>(last - first)};
+			return e.first.size() >= size
+				&& std::char_traits<char>::compare(e.first.data(), first, size) == 0;
+		}
 };
 
 
@@ -387,7 +1538,8 @@ class SinkArg : public Arg
 class Parser
 {
 	using ArgPtr = std::unique_ptr<Arg>;
-	using ParseIt = std::vector<std::string>::const_iterator;
+	using ParseIt = std::vector<Token>::const_iterator;
+	using StringIt = const char*;
 	using StringSize = std::string::size_type;
 
 	public:
@@ -401,32 +1553,107 @@ class Parser
 
 		// ---- Arguments ----
 
-		void addSignal(
+		void addSignal(
+			char shortName,
+			std::string longName,
+			std::string description)
+		{
+			checkFrozen();
+			isIndexed_ = false;
+			options_.push_back(ArgPtr{new SignalArg{
+				shortName,
+				std::move(longName),
+				std::move(description) }});
+		}
+
+		void addOption(
+			bool& target,
+			char shortName,
+			std::string longName,
+			std::string description,
+			bool isRequired = false)
+		{
+			checkFrozen();
+			isIndexed_ = false;
+			options_.push_back(ArgPtr{new BoolArg{
+				shortName,
+				std::move(longName),
+				std::move(description),
+				isRequired,
+				target }});
+		}
+
+		template<typename T>
+		void addOption(
+			T& target,
+			char shortName,
+			std::string longName,
+			std::string valueName,
+			std::string description,
+			bool isRequired = false)
+		{
+			checkFrozen();
+			isIndexed_ = false;
+			options_.push_back(ArgPtr{new ValueArg<T>{
+				shortName,
+				std::move(longName),
+				std::move(valueName),
+				std::move(description),
+				isRequired,
+				target,
+				makeDefault(target) }});
+		}
+
+		// Appends each occurrence. With a delimiter, each
+		// value is split into multiple elements.
+		template<template<typename...> class Container, typename T>
+		void addOptionSink(
+			Container<T>& target,
 			char shortName,
 			std::string longName,
-			std::string description)
+			std::string valueName,
+			std::string description,
+			char delimiter,
+			bool isRequired = false)
 		{
-			options_.push_back(ArgPtr{new SignalArg{
+			checkFrozen();
+			isIndexed_ = false;
+			options_.push_back(ArgPtr{new SinkArg<Container, T>{
 				shortName,
 				std::move(longName),
-				std::move(description) }});
+				std::move(valueName),
+				std::move(description),
+				isRequired,
+				delimiter,
+				target }});
 		}
 
-		void addOption(
-			bool& target,
+		// Splits each value at the first separator into a key and a value.
+		// If a key is repeated, the last value takes precedence.
+		template<typename Map>
+		void addOptionMap(
+			Map& target,
 			char shortName,
 			std::string longName,
+			std::string valueName,
 			std::string description,
+			char separator = '=',
 			bool isRequired = false)
 		{
-			options_.push_back(ArgPtr{new BoolArg{
+			checkFrozen();
+			isIndexed_ = false;
+			hasMapOptions_ = true;
+			options_.push_back(ArgPtr{new MapArg<Map>{
 				shortName,
 				std::move(longName),
+				std::move(valueName),
 				std::move(description),
 				isRequired,
+				separator,
 				target }});
 		}
 
+		// Accepts only the names of the given choices
 		template<typename T>
 		void addOption(
 			T& target,
@@ -434,15 +1661,20 @@ class Parser
 			std::string longName,
 			std::string valueName,
 			std::string description,
+			std::vector<std::pair<std::string, T>> choices,
 			bool isRequired = false)
 		{
-			options_.push_back(ArgPtr{new ValueArg<T>{
+			checkFrozen();
+			isIndexed_ = false;
+			options_.push_back(ArgPtr{new ChoiceArg<T>{
 				shortName,
 				std::move(longName),
 				std::move(valueName),
 				std::move(description),
 				isRequired,
-				target }});
+				std::move(choices),
+				target,
+				makeDefault(target) }});
 		}
 
 		template<typename T>
@@ -452,13 +1684,15 @@ class Parser
 			std::string description,
 			bool isRequired = false)
 		{
+			checkFrozen();
 			operands_.push_back(ArgPtr{new ValueArg<T>{
 				0,
 				{},
 				std::move(valueName),
 				std::move(description),
 				isRequired,
-				target }});
+				target,
+				makeDefault(target) }});
 		}
 
 		template<template<typename...> class Container, typename T>
@@ -468,10 +1702,14 @@ class Parser
 			std::string description,
 			bool isRequired = false)
 		{
+			checkFrozen();
 			operands_.push_back(ArgPtr{new SinkArg<Container, T>{
+				0,
+				{},
 				std::move(valueName),
 				std::move(description),
 				isRequired,
+				0,
 				target }});
 		}
 
@@ -479,15 +1717,110 @@ class Parser
 		// Expects standard argc and argv parameters
 		// https://en.cppreference.com/w/cpp/language/main_function
 
+		// The arguments are not copied, only the option
+		// values are copied into a reused buffer
+
 		void parse(int argc, const char* const argv[])
 		{
-			parse({argv, argv + argc});
+			tokens_.clear();
+			for (int i{0}; i < argc; ++i)
+				tokens_.push_back(Token{argv[i], argv[i] + std::strlen(argv[i])});
+			parseTokens();
 		}
 
 		void parse(const std::vector<std::string>& argv)
 		{
-			ParseIt it{argv.begin()};
-			parseAll(it, argv.end());
+			tokens_.clear();
+			for (const auto& arg : argv)
+				tokens_.push_back(Token{arg.data(), arg.data() + arg.size()});
+			parseTokens();
+		}
+
+		// Like parse, but returns all errors instead of throwing the
+		// first one. Parsing resumes at the next argument after an error.
+		std::vector<Error> validate(int argc, const char* const argv[])
+		{
+			return collectErrors([&]{ parse(argc, argv); });
+		}
+
+		std::vector<Error> validate(const std::vector<std::string>& argv)
+		{
+			return collectErrors([&]{ parse(argv); });
+		}
+
+		// Expects a single string with POSIX shell quoting,
+		// starting with the utility name. Unquoted words are
+		// passed to the parser as views into the string.
+		void parseCommandLine(const std::string& commandLine)
+		{
+			try
+			{
+				splitCommandLine(commandLine, lineBuffer_, tokens_);
+			}
+			catch (Error& e)
+			{
+				// The tokens end before the offending word
+				report(e, tokens_.size());
+				return;
+			}
+			parseTokens();
+		}
+
+		// Like parseCommandLine, but returns all errors. An unclosed
+		// quote or missing escaped character is the only error.
+		std::vector<Error> validateCommandLine(const std::string& commandLine)
+		{
+			return collectErrors([&]{ parseCommandLine(commandLine); });
+		}
+
+		// ---- Memory ----
+
+		Footprint getFootprint() const
+		{
+			Footprint f{};
+			f.parser = sizeof(*this);
+			f.arguments = heapSize(options_) + heapSize(operands_);
+
+			for (const auto& option : options_)
+				option->addFootprint(f);
+			for (const auto& operand : operands_)
+				operand->addFootprint(f);
+
+			for (const std::string* text : getTexts())
+				f.names += heapSize(*text);
+
+			for (const auto& shared : defaults_)
+				f.defaults += sizeof(shared) + shared.second->getSize();
+
+			index_.addFootprint(f);
+			f.buffers += heapSize(valueBuffer_) + heapSize(lineBuffer_) + heapSize(tokens_);
+			return f;
+		}
+
+		// Builds the index and releases all spare capacity of the
+		// schema. Afterwards, the add* functions throw std::logic_error,
+		// which is a programming error, unlike the parse errors.
+		void freeze()
+		{
+			buildIndex();
+			index_.shrink();
+
+			options_.shrink_to_fit();
+			operands_.shrink_to_fit();
+			for (const auto& option : options_)
+				option->shrink();
+			for (const auto& operand : operands_)
+				operand->shrink();
+
+			for (std::string* text : getTexts())
+				text->shrink_to_fit();
+
+			isFrozen_ = true;
+		}
+
+		bool isFrozen() const
+		{
+			return isFrozen_;
 		}
 
 		// ---- Settings ----
@@ -495,6 +1828,11 @@ class Parser
 		void setShortOptionPrefix(char c)        { shortPrefix_   = c; }
 		void setLongOptionPrefix(std::string s)  { longPrefix_    = std::move(s); }
 		void setLongOptionSeparator(char c)      { longSeparator_ = c; }
+		void setLongOptionAbbreviation(bool b)   { isAbbreviated_ = b; }
+		void setOptionSuggestions(bool b)        { isSuggested_   = b; }
+		void setTrusted(bool b)                  { isTrusted_ = b; }
+		void setOptionPermutation(bool b)        { isPermuted_ = b; }
+		void setObserver(Observer* o)            { observer_ = o; }
 		void setOptionTerminator(std::string s)  { terminator_    = std::move(s); }
 		void setUsageTitle(std::string s)        { usageTitle_    = std::move(s); }
 		void setOptionsTitle(std::string s)      { optionsTitle_  = std::move(s); }
@@ -503,6 +1841,7 @@ class Parser
 		void setOptionsUsage(std::string s)      { optionsUsage_  = std::move(s); }
 		void setOperandsUsage(std::string s)     { operandsUsage_ = std::move(s); }
 		void setDefaultValueIntro(std::string s) { defaultIntro_  = std::move(s); }
+		void setChoicesIntro(std::string s)      { choicesIntro_  = std::move(s); }
 		void setHelpWidth(StringSize s)          { helpWidth_     = s > 0 ? s : 0; }
 		void setHelpIndent(StringSize s)         { helpIndent_    = s > 0 ? s : 0; }
 
@@ -511,8 +1850,15 @@ class Parser
 		char shortPrefix_{'-'};
 		std::string longPrefix_{"--"};
 		char longSeparator_{'='};
+		bool isAbbreviated_{false};
+		bool isSuggested_{true};
+		bool isTrusted_{false};
+		bool isPermuted_{false};
+		bool isFrozen_{false};
+		Observer* observer_{nullptr};
 		std::string terminator_{"--"};
 		bool isTerminated_{false};
+		std::size_t nextOperand_{0};
 
 		std::string helpProlog_{};
 		std::string helpEpilog_{};
@@ -523,6 +1869,7 @@ class Parser
 		std::string optionsUsage_{};
 		std::string operandsUsage_{};
 		std::string defaultIntro_{"default: "};
+		std::string choicesIntro_{"choices: "};
 
 		StringSize helpWidth_{80};
 		StringSize helpIndent_{2};
@@ -531,18 +1878,169 @@ class Parser
 		std::vector<ArgPtr> options_{};
 		std::vector<ArgPtr> operands_{};
 
+		// Defaults that are not copied, by target and type
+		std::map<std::pair<const void*, const void*>, std::shared_ptr<SharedDefault>> defaults_{};
+
+		OptionIndex index_{};
+		bool isIndexed_{false};
+		bool hasMapOptions_{false};
+
+		// Only valid during parsing
+		ParseIt begin_{};
+		std::vector<Error>* errors_{nullptr};
+
+		// Reused for each parse, tokens may point into the line buffer
+		std::vector<Token> tokens_{};
+		std::string lineBuffer_{};
+
+		// Reused for each option value or operand, before its conversion
+		std::string valueBuffer_{};
+
+		enum class TokenKind
+		{
+			operand,
+			terminator,
+			longOption,
+			shortOptions
+		};
+
 		// ---- Parse ----
 
-		void parseAll(ParseIt& it, ParseIt end)
+		void parseAll(ParseIt& it, ParseIt end);
+
+		void parseTokens()
+		{
+			ParseIt it{tokens_.cbegin()};
+			parseAll(it, tokens_.cend());
+		}
+
+		// Records the errors of the parse function, instead of throwing them
+		template<typename Parse>
+		std::vector<Error> collectErrors(Parse parse)
+		{
+			std::vector<Error> errors{};
+			errors_ = &errors;
+
+			try
+			{
+				parse();
+			}
+			catch (...)
+			{
+				errors_ = nullptr;
+				throw;
+			}
+
+			errors_ = nullptr;
+			return errors;
+		}
+
+		// Forwards the event, costs a single branch without observer
+		template<typename... Params, typename... Args>
+		void notify(void (Observer::*event)(Params...), Args&&... args) const
+		{
+			if (observer_ != nullptr)
+				(observer_->*event)(std::forward<Args>(args)...);
+		}
+
+		void convert(Arg* arg, StringIt first, StringIt last)
+		{
+			valueBuffer_.assign(first, last);
+			notify(&Observer::onConversion, static_cast<const std::string&>(valueBuffer_));
+			arg->parse(valueBuffer_);
+		}
+
+		void convert(Arg* arg, const Token& token)
+		{
+			convert(arg, token.begin(), token.end());
+		}
+
+		void notifyToken(const Token& token) const
+		{
+			notify(&Observer::onToken, token.begin(), token.end());
+		}
+
+		template<typename T>
+		DefaultValue<T> makeDefault(T& target)
+		{
+			std::shared_ptr<SharedDefault>& shared{defaults_[{&target, &TypeTag<T>::id}]};
+			if (shared == nullptr)
+				shared = std::make_shared<SavedValue<T>>();
+			return DefaultValue<T>{target, std::static_pointer_cast<SavedValue<T>>(shared)};
+		}
+
+		void checkFrozen() const
 		{
-			parseUtility(it, end);
-			parseOptions(it, end);
-			parseOperands(it, end);
-			parseTerminator(it, end);
+			if (isFrozen_)
+				throw std::logic_error{"Cannot add arguments to a frozen parser"};
+		}
+
+		std::array<const std::string*, 12> getTexts() const
+		{
+			return {{&longPrefix_, &terminator_, &helpProlog_, &helpEpilog_,
+				&usageTitle_, &optionsTitle_, &operandsTitle_, &utilityName_,
+				&optionsUsage_, &operandsUsage_, &defaultIntro_, &choicesIntro_}};
+		}
+
+		std::array<std::string*, 12> getTexts()
+		{
+			return {{&longPrefix_, &terminator_, &helpProlog_, &helpEpilog_,
+				&usageTitle_, &optionsTitle_, &operandsTitle_, &utilityName_,
+				&optionsUsage_, &operandsUsage_, &defaultIntro_, &choicesIntro_}};
+		}
+
+		// Validation always runs all checks
+		bool isTrusted() const
+		{
+			return isTrusted_ && errors_ == nullptr;
+		}
 
+		// Trusted arguments must pass the skipped checks in debug builds,
+		// the observer only sees what the trusted parse does
+		void assertChecks(ParseIt it, ParseIt end)
+		{
+#ifndef NDEBUG
+			std::vector<Error> errors{};
+			Observer* observer{observer_};
+			errors_ = &errors;
+			observer_ = nullptr;
 			checkEnd(it, end);
-			checkRequired(options_);
-			checkRequired(operands_);
+			checkRequired(options_, end);
+			checkRequired(operands_, end);
+			observer_ = observer;
+			errors_ = nullptr;
+			assert(errors.empty() && "Trusted arguments are invalid");
+#else
+			static_cast<void>(it);
+			static_cast<void>(end);
+#endif
+		}
+
+		void resetState(ParseIt begin)
+		{
+			begin_ = begin;
+			isTerminated_ = false;
+			nextOperand_ = 0;
+
+			for (auto& option : options_)
+				option->reset();
+			for (auto& operand : operands_)
+				operand->reset();
+		}
+
+		// Throws the error, or records it during validation
+		void report(Error& error, ParseIt pos) const
+		{
+			report(error, static_cast<std::size_t>(std::distance(begin_, pos)));
+		}
+
+		void report(Error& error, std::size_t index) const
+		{
+			error.index = index;
+			notify(&Observer::onError, static_cast<const Error&>(error));
+			if (errors_ == nullptr)
+				throw error;
+			errors_->push_back(error);
 		}
 
 		void parseUtility(ParseIt& it, ParseIt end)
@@ -551,30 +2049,118 @@ class Parser
 				return;
 
 			if (utilityName_.empty())
-				utilityName_ = *it;
+				utilityName_ = it->str();
 			++it;
 		}
 
+		void buildIndex()
+		{
+			if (isIndexed_)
+				return;
+
+			index_.clear();
+			for (auto& option : options_)
+				index_.insert(option.get());
+			index_.build();
+			isIndexed_ = true;
+		}
+
+		// Long options take precedence over short options,
+		// in case that the prefixes are identical
+		TokenKind classify(const Token& token) const
+		{
+			if (isTerminated_)
+				return TokenKind::operand;
+
+			if (!terminator_.empty() && token == terminator_)
+				return TokenKind::terminator;
+
+			if (!longPrefix_.empty()
+				&& token.size() > longPrefix_.size()
+				&& token.startsWith(longPrefix_))
+				return TokenKind::longOption;
+
+			if (token.size() > 1 && token.front() == shortPrefix_)
+				return TokenKind::shortOptions;
+
+			return TokenKind::operand;
+		}
+
 		void parseOptions(ParseIt& it, ParseIt end)
 		{
-			while (true)
+			while (it != end)
 			{
-				auto old{it};
+				const ParseIt old{it};
+				const TokenKind kind{classify(*it)};
+				if (kind == TokenKind::operand && !isPermuted_)
+					return;
 
-				parseTerminator(it, end);
-				if (it != old)
-					break;
+				notifyToken(*it);
+				try
+				{
+					switch (kind)
+					{
+						case TokenKind::terminator:
+							parseTerminator(it, end);
+							return;
+						case TokenKind::longOption:
+							parseLongOption(it, end);
+							break;
+						case TokenKind::shortOptions:
+							parseShortOptions(it, end);
+							break;
+						case TokenKind::operand:
+							parseOperand(it);
+							break;
+					}
+				}
+				catch (Error& e)
+				{
+					// The option token is always consumed
+					report(e, old);
+				}
+			}
+		}
+
+		// Counts the values of each option before the parse, so that maps
+		// reserve their buckets once. Only runs with map options. Each name
+		// is resolved with a single lookup, and invalid options are skipped,
+		// because the parse reports them.
+		void reserveValues(ParseIt it, ParseIt end)
+		{
+			if (!hasMapOptions_)
+				return;
 
-				parseLongOption(it, end);
-				if (it != old)
+			for (; it != end; ++it)
+			{
+				const TokenKind kind{classify(*it)};
+				if (kind == TokenKind::terminator || (kind == TokenKind::operand && !isPermuted_))
+					break;
+				if (kind == TokenKind::operand)
 					continue;
 
-				parseShortOptions(it, end);
-				if (it != old)
+				Arg* option{nullptr};
+				StringIt nameIt{it->begin()};
+				if (kind == TokenKind::longOption)
+				{
+					nameIt += longPrefix_.size();
+					option = index_.findLong(nameIt, it->end(), longSeparator_, isAbbreviated_);
+				}
+				else
+					for (++nameIt; nameIt != it->end(); )
+						if ((option = index_.findShort(*nameIt++)) == nullptr || option->hasValue())
+							break;
+
+				if (option == nullptr || !option->hasValue())
 					continue;
 
-				break;
+				option->expect();
+				if (nameIt == it->end() && std::next(it) != end)
+					++it;
 			}
+
+			for (auto& option : options_)
+				option->reserve();
 		}
 
 		void parseTerminator(ParseIt& it, ParseIt end)
@@ -586,56 +2172,33 @@ class Parser
 			++it;
 		}
 
-		bool predictLongOption(const ParseIt& it, ParseIt end) const
-		{
-			return it != end
-				&& !isTerminated_
-				&& !longPrefix_.empty()
-				&& it->size() > longPrefix_.size()
-				&& it->compare(0, longPrefix_.size(), longPrefix_) == 0;
-		}
-
 		void parseLongOption(ParseIt& it, ParseIt end)
 		{
-			if (!predictLongOption(it, end))
-				return;
-
-			const std::string& token{*it++};
+			const Token& token{*it++};
 			auto nameIt{std::next(token.begin(), longPrefix_.size())};
-			auto sepIt{std::find(nameIt, token.end(), longSeparator_)};
+			auto sepIt{nameIt};
 
-			Arg* option{getOption({nameIt, sepIt})};
+			Arg* option{getOption(nameIt, sepIt, token.end())};
 			if (option->hasValue())
 			{
 				if (sepIt != token.end())
-					option->parse({std::next(sepIt), token.end()});
+					convert(option, std::next(sepIt), token.end());
 				else
 				{
 					if (it == end)
-						throw Error{"Cannot find value for option: " + token};
-					option->parse(*it++);
+						throw Error{Error::Kind::missingValue, token.str()};
+					convert(option, *it++);
 				}
 			}
 			else
 				if (sepIt != token.end())
-					throw Error{"Unexpected option value: " + token};
+					throw Error{Error::Kind::unexpectedValue, token.str()};
 			option->done();
 		}
 
-		bool predictShortOption(const ParseIt& it, ParseIt end) const
-		{
-			return it != end
-				&& !isTerminated_
-				&& it->size() > 1
-				&& it->front() == shortPrefix_;
-		}
-
 		void parseShortOptions(ParseIt& it, ParseIt end)
 		{
-			if (!predictShortOption(it, end))
-				return;
-
-			const std::string& token{*it++};
+			const Token& token{*it++};
 			auto nameIt{std::next(token.begin())};
 
 			while (nameIt != token.end())
@@ -645,14 +2208,14 @@ class Parser
 				{
 					if (nameIt != token.end())
 					{
-						option->parse(std::string{nameIt, token.end()});
+						convert(option, nameIt, token.end());
 						nameIt = token.end();
 					}
 					else
 					{
 						if (it == end)
-							throw Error{"Cannot find value for option: " + token};
-						option->parse(*it++);
+							throw Error{Error::Kind::missingValue, token.str()};
+						convert(option, *it++);
 					}
 				}
 				option->done();
@@ -661,8 +2224,23 @@ class Parser
 
 		void parseOperands(ParseIt& it, ParseIt end)
 		{
-			for (auto& operand : operands_)
-				parseOperandContent(it, end, operand.get());
+			for (; nextOperand_ < operands_.size(); ++nextOperand_)
+				parseOperandContent(it, end, operands_[nextOperand_].get());
+		}
+
+		// Assigns an operand among the options, in the same order
+		// as parseOperands, which continues after the terminator
+		void parseOperand(ParseIt& it)
+		{
+			const Token& token{*it++};
+			if (nextOperand_ == operands_.size())
+				throw Error{Error::Kind::unexpectedArgument, token.str()};
+
+			Arg* operand{operands_[nextOperand_].get()};
+			if (!operand->isSink())
+				++nextOperand_;
+			convert(operand, token);
+			operand->done();
 		}
 
 		void parseOperandContent(ParseIt& it, ParseIt end, Arg* operand)
@@ -673,11 +2251,23 @@ class Parser
 				if (it == end)
 					break;
 
-				if (predictLongOption(it, end) || predictShortOption(it, end))
-					throw Error{"Unexpected option: " + *it};
+				const ParseIt old{it++};
+				notifyToken(*old);
+				try
+				{
+					if (isTrusted())
+						assert(classify(*old) == TokenKind::operand && "Trusted arguments are invalid");
+					else if (classify(*old) != TokenKind::operand)
+						throw Error{Error::Kind::unexpectedOption, old->str()};
+
+					convert(operand, *old);
+					operand->done();
+				}
+				catch (Error& e)
+				{
+					report(e, old);
+				}
 
-				operand->parse(*it++);
-				operand->done();
 				if (!operand->isSink())
 					break;
 			}
@@ -685,15 +2275,21 @@ class Parser
 
 		void checkEnd(ParseIt& it, ParseIt end) const
 		{
-			if (it != end)
-				throw Error{"Unexpected argument: " + *it};
+			for (; it != end; ++it)
+			{
+				Error error{Error::Kind::unexpectedArgument, it->str()};
+				report(error, it);
+			}
 		}
 
-		void checkRequired(const std::vector<ArgPtr>& args) const
+		void checkRequired(const std::vector<ArgPtr>& args, ParseIt end) const
 		{
 			for (const auto& arg : args)
 				if (arg->isRequired() && !arg->isDone())
-					throw Error{"Cannot find required argument: " + expandName(arg.get())};
+				{
+					Error error{Error::Kind::missingArgument, expandName(arg.get())};
+					report(error, end);
+				}
 		}
 
 		std::string expandName(const Arg* arg) const
@@ -705,36 +2301,94 @@ class Parser
 			return arg->getValueName();
 		}
 
-		Arg* getOption(const std::string& name)
+		// Advances sepIt from nameIt to the separator or the end
+		Arg* getOption(StringIt nameIt, StringIt& sepIt, StringIt end) const
+		{
+			notify(&Observer::onLookup);
+			sepIt = nameIt;
+			Arg* option{index_.findLong(sepIt, end, longSeparator_, isAbbreviated_)};
+			if (option != nullptr)
+			{
+				notify(&Observer::onOption, option->getShortName(), option->getLongName());
+				return option;
+			}
+
+			// The name is reported with its prefix, like the candidates
+			std::string name{nameIt, sepIt};
+			if (isAbbreviated_ && !name.empty())
+			{
+				auto candidates{index_.findAbbreviated(nameIt, sepIt)};
+				if (candidates.size() > 1)
+				{
+					std::vector<std::string> names{};
+					for (const Arg* candidate : candidates)
+						names.push_back(longPrefix_ + candidate->getLongName());
+					std::sort(names.begin(), names.end());
+					throw Error{Error::Kind::ambiguousOption, longPrefix_ + name, std::move(names)};
+				}
+			}
+
+			auto suggestions{suggest(name)};
+			throw Error{Error::Kind::unknownOption, longPrefix_ + name, std::move(suggestions)};
+		}
+
+		Arg* getOption(char name) const
+		{
+			notify(&Observer::onLookup);
+			Arg* option{index_.findShort(name)};
+			if (option == nullptr)
+				throw Error{Error::Kind::unknownOption, std::string{shortPrefix_, name}, suggest(name)};
+			notify(&Observer::onOption, option->getShortName(), option->getLongName());
+			return option;
+		}
+
+		// Suggests the closest long and short names for a misspelled long name
+		std::vector<std::string> suggest(const std::string& name) const
 		{
-			if (!name.empty())
-				for (auto& option : options_)
-					if (option->getLongName() == name)
-						return option.get();
-			throw Error{"Unknown option name: " + name};
+			if (!isSuggested_ || isTrusted() || name.empty() || name.size() > 64)
+				return {};
+
+			std::size_t best{std::max<std::size_t>(1, name.size() / 3)};
+			const std::vector<const Arg*> closest{index_.findClosest(name, best)};
+
+			// Short name with long prefix, which is an exact match
+			const bool isShortName{name.size() == 1 && index_.findShort(name.front()) != nullptr};
+
+			// The prefixed names are only built for the closest candidates
+			std::vector<std::string> matches{};
+			if (isShortName)
+				matches.push_back(std::string{shortPrefix_, name.front()});
+			if (!isShortName || best == 0)
+				for (const Arg* option : closest)
+					matches.push_back(longPrefix_ + option->getLongName());
+
+			std::sort(matches.begin(), matches.end());
+			matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+			return matches;
 		}
 
-		Arg* getOption(char name)
+		// Suggests a short name that only differs in case
+		std::vector<std::string> suggest(char name) const
 		{
-			if (name != 0)
-				for (auto& option : options_)
-					if (option->getShortName() == name)
-						return option.get();
-			throw Error{"Unknown option name: " + std::string{name}};
+			std::vector<std::string> matches{};
+			if (!isSuggested_ || isTrusted())
+				return matches;
+
+			for (char c : {
+				static_cast<char>(std::tolower(static_cast<unsigned char>(name))),
+				static_cast<char>(std::toupper(static_cast<unsigned char>(name)))})
+				if (c != name && index_.findShort(c) != nullptr)
+					matches.push_back(std::string{shortPrefix_, c});
+
+			std::sort(matches.begin(), matches.end());
+			return matches;
 		}
 
 		// ---- Write ----
 
 		friend std::ostream& operator<<(std::ostream&, const Parser&);
 
-		void writeHelp(std::ostream& out) const
-		{
-			writeParagraph(out, helpProlog_);
-			writeUsage(out);
-			writeGlossary(out, optionsTitle_, options_);
-			writeGlossary(out, operandsTitle_, operands_);
-			writeParagraph(out, helpEpilog_);
-		}
+		void writeHelp(std::ostream& out) const;
 
 		void writeParagraph(std::ostream& out, const std::string& paragraph) const
 		{
@@ -854,6 +2508,19 @@ class Parser
 					entry.term += arg->getValueName();
 				}
 
+				if (!choicesIntro_.empty())
+				{
+					std::vector<std::string> choices{arg->getChoices()};
+					if (!choices.empty())
+					{
+						std::string list{'(' + choicesIntro_};
+						for (const auto& choice : choices)
+							list += (&choice == &choices.front() ? "" : ", ") + choice;
+						auto tokens{tokenize(list + ')')};
+						entry.description.insert(entry.description.end(), tokens.begin(), tokens.end());
+					}
+				}
+
 				if (!defaultIntro_.empty())
 				{
 					std::string value{arg->getDefaultValue()};
@@ -951,6 +2618,189 @@ class Parser
 };
 
 
+// ---- Separate compilation ----
+
+// With MINARG_SEPARATE_COMPILATION, the parse and help entry points
+// and the option index are compiled once in src/minarg.cpp. The rest
+// of the non-template parser code is then only used there. The common template instances
+// are declared separately, in minarg/instances.hpp.
+
+#if !defined(MINARG_SEPARATE_COMPILATION) || defined(MINARG_SOURCE)
+
+MINARG_DECL void OptionIndex::build()
+{
+	// Sorted positions, the first duplicate takes precedence
+	std::vector<std::size_t> positions(longNames_.size());
+	for (std::size_t i{0}; i < positions.size(); ++i)
+		positions[i] = i;
+	std::sort(positions.begin(), positions.end(),
+		[this](std::size_t a, std::size_t b)
+		{
+			const int order{longNames_[a].first.compare(longNames_[b].first)};
+			return order < 0 || (order == 0 && a < b);
+		});
+
+	std::vector<Entry> sorted{};
+	sorted.reserve(positions.size());
+	for (std::size_t i : positions)
+		if (sorted.empty() || sorted.back().first != longNames_[i].first)
+			sorted.push_back(std::move(longNames_[i]));
+	longNames_ = std::move(sorted);
+
+	// At most half full, so that probe sequences stay short
+	std::size_t size{1};
+	while (size < longNames_.size() * 2)
+		size *= 2;
+	slots_.assign(size, 0);
+
+	for (std::size_t i{0}; i < longNames_.size(); ++i)
+	{
+		const std::string& name{longNames_[i].first};
+		std::size_t slot{hash(name.data(), name.data() + name.size()) & (size - 1)};
+		while (slots_[slot] != 0)
+			slot = (slot + 1) & (size - 1);
+		slots_[slot] = i + 1;
+	}
+}
+
+
+MINARG_DECL Arg* OptionIndex::findLong(StringIt& it, StringIt end, char separator, bool isAbbreviated) const
+{
+	// Hash the name while searching the separator
+	const StringIt first{it};
+	std::size_t h{hashBasis};
+	for (; it != end && *it != separator; ++it)
+		h = hashStep(h, *it);
+
+	const std::size_t size{static_cast<std::size_t>(it - first)};
+	const std::size_t mask{slots_.size() - 1};
+	for (std::size_t slot{h & mask}; !slots_.empty() && slots_[slot] != 0; slot = (slot + 1) & mask)
+	{
+		const Entry& e{longNames_[slots_[slot] - 1]};
+		if (e.first.size() == size && std::char_traits<char>::compare(e.first.data(), first, size) == 0)
+			return e.second;
+	}
+
+	if (!isAbbreviated || size == 0)
+		return nullptr;
+
+	auto entry{lowerBound(first, it)};
+	if (entry == longNames_.end() || !startsWith(*entry, first, it))
+		return nullptr;
+
+	// Unambiguous if the next name has a different prefix
+	if (std::next(entry) == longNames_.end() || !startsWith(*std::next(entry), first, it))
+		return entry->second;
+	return nullptr;
+}
+
+
+MINARG_DECL std::vector<const Arg*> OptionIndex::findClosest(const std::string& name, std::size_t& maxDistance) const
+{
+	const EditDistance distance{name};
+	std::vector<const Arg*> closest{};
+
+	// State after each char of the previous name
+	std::vector<EditDistance::State> states{distance.start()};
+	const std::string* previous{nullptr};
+
+	auto it{longNames_.begin()};
+	while (it != longNames_.end())
+	{
+		const std::string& longName{it->first};
+		std::size_t depth{0};
+		if (previous != nullptr)
+			depth = static_cast<std::size_t>(std::mismatch(
+				previous->begin(), previous->begin() + std::min(previous->size(), longName.size()),
+				longName.begin()).first - previous->begin());
+		depth = std::min(depth, states.size() - 1);
+		states.resize(depth + 1);
+		previous = &longName;
+
+		// Continue from the shared prefix
+		while (depth < longName.size() && distance.isReachable(states[depth], maxDistance))
+		{
+			states.push_back(distance.step(states[depth], longName[depth]));
+			++depth;
+		}
+
+		if (depth == longName.size())
+		{
+			if (states[depth].score <= maxDistance)
+			{
+				if (states[depth].score < maxDistance)
+				{
+					maxDistance = states[depth].score;
+					closest.clear();
+				}
+				closest.push_back(it->second);
+			}
+			++it;
+			continue;
+		}
+
+		// Skip all names with the unreachable prefix
+		const StringIt first{longName.data()};
+		const StringIt last{first + depth + 1};
+		while (it != longNames_.end() && startsWith(*it, first, last))
+			++it;
+	}
+
+	return closest;
+}
+
+
+MINARG_DECL std::vector<const Arg*> OptionIndex::findAbbreviated(StringIt first, StringIt last) const
+{
+	std::vector<const Arg*> args{};
+	for (auto it{lowerBound(first, last)}; it != longNames_.end() && startsWith(*it, first, last); ++it)
+		args.push_back(it->second);
+	return args;
+}
+
+
+MINARG_DECL void Parser::parseAll(ParseIt& it, ParseIt end)
+{
+	notify(&Observer::onPhase, Observer::Phase::setup);
+	buildIndex();
+	resetState(it);
+
+	notify(&Observer::onPhase, Observer::Phase::utility);
+	parseUtility(it, end);
+
+	notify(&Observer::onPhase, Observer::Phase::options);
+	reserveValues(it, end);
+	parseOptions(it, end);
+
+	notify(&Observer::onPhase, Observer::Phase::operands);
+	parseOperands(it, end);
+	parseTerminator(it, end);
+
+	notify(&Observer::onPhase, Observer::Phase::checks);
+	if (isTrusted())
+		assertChecks(it, end);
+	else
+	{
+		checkEnd(it, end);
+		checkRequired(options_, end);
+		checkRequired(operands_, end);
+	}
+	notify(&Observer::onPhase, Observer::Phase::done);
+}
+
+
+MINARG_DECL void Parser::writeHelp(std::ostream& out) const
+{
+	writeParagraph(out, helpProlog_);
+	writeUsage(out);
+	writeGlossary(out, optionsTitle_, options_);
+	writeGlossary(out, operandsTitle_, operands_);
+	writeParagraph(out, helpEpilog_);
+}
+
+#endif
+
+
 inline std::ostream& operator<<(std::ostream& out, const Parser& parser)
 {
 	parser.writeHelp(out);
@@ -965,6 +2815,9 @@ inline std::ostream& operator<<(std::ostream& out, const Parser& parser)
 using detail::Parser;
 using detail::Error;
 using detail::Signal;
+using detail::Observer;
+using detail::Counters;
+using detail::Footprint;
 
 
 } // namespace minarg
@@ -0,0 +1,11 @@
+// Compiles the common template instances, which minarg/instances.hpp
+// declares as external. The minarg_static library compiles this file
+// once per type, with MINARG_INSTANCE, so that a program only links
+// the instances that it uses.
+
+#ifndef MINARG_SEPARATE_COMPILATION
+#define MINARG_SEPARATE_COMPILATION
+#endif
+
+#define MINARG_INSTANCES_SOURCE
+#include <minarg/instances.hpp>
@@ -0,0 +1,10 @@
+// Compiles the parser entry points once, for the minarg_static library.
+// Its users are compiled with MINARG_SEPARATE_COMPILATION, which
+// declares them as external.
+
+#ifndef MINARG_SEPARATE_COMPILATION
+#define MINARG_SEPARATE_COMPILATION
+#endif
+
+#define MINARG_SOURCE
+#include <minarg/minarg.hpp>
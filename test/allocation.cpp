@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <minarg/minarg.hpp>
+#include <minarg/instances.hpp>
+
+#include "allocations.hpp"
+#include "bench.hpp"
+
+
+TEST_CASE("allocation budget")
+{
+	bool a{false};
+	int i{0};
+	unsigned u{0};
+	std::string s{};
+	std::string o{};
+
+	minarg::Parser parser{};
+	parser.addOption(a, 'a', "aaa", "");
+	parser.addOption(i, 'i', "iii", "", "");
+	parser.addOption(u, 'u', "uuu", "", "");
+	parser.addOption(s, 's', "sss", "", "");
+	parser.addOperand(o, "", "");
+
+	const auto parse = [&](const std::vector<std::string>& argv)
+	{
+		return bench::measureAllocations([&]{ parser.parse(argv); }).count;
+	};
+
+	SECTION("first parse allocates")
+	{
+		REQUIRE(parse({"", "-i1"}) > 0);
+	}
+	SECTION("reparse integer options")
+	{
+		const std::vector<std::string> argv{"", "-a", "-i1", "-u", "2", "--iii=3", "--uuu", "4"};
+		parse(argv);
+		REQUIRE(parse(argv) == 0);
+		REQUIRE(i == 3);
+		REQUIRE(u == 4);
+	}
+	SECTION("reparse with counters")
+	{
+		minarg::Counters counters{};
+		parser.setObserver(&counters);
+		const std::vector<std::string> argv{"", "-a", "-i1", "--sss=a value longer than the small string buffer", "operand"};
+		parse(argv);
+		REQUIRE(parse(argv) == 0);
+		REQUIRE(counters.getTokens() == 8);
+	}
+	SECTION("reparse string options and operands with sufficient capacity")
+	{
+		const std::vector<std::string> argv{"", "-sFIRST", "--sss=second", "operand"};
+		parse(argv);
+		REQUIRE(parse(argv) == 0);
+		REQUIRE(s == "second");
+		REQUIRE(o == "operand");
+	}
+	SECTION("first parse reuses the capacity of string targets")
+	{
+		s.reserve(64);
+		const char* data{s.data()};
+		parse({"", "--sss=a value longer than the small string buffer"});
+		REQUIRE(s.data() == data);
+	}
+	SECTION("allocations by phase")
+	{
+		using Phase = minarg::Observer::Phase;
+		bench::PhaseAllocations phases{};
+		parser.setObserver(&phases);
+		const std::vector<std::string> argv{"", "-a", "-i1", "--sss=second", "operand"};
+
+		parser.parse(argv);
+		REQUIRE(phases.getParses() == 1);
+		REQUIRE(phases.get(static_cast<std::size_t>(Phase::setup)).count > 0);
+		REQUIRE(phases.get(static_cast<std::size_t>(Phase::checks)).count == 0);
+
+		phases.clear();
+		parser.parse(argv);
+		REQUIRE(phases.getParses() == 1);
+		for (std::size_t i{0}; i < bench::PhaseAllocations::phaseCount; ++i)
+			REQUIRE(phases.get(i).count == 0);
+	}
+	SECTION("argv is not copied")
+	{
+		const char* argv[]{"", "-i1"};
+		parse({"", "-i1"});
+		REQUIRE(bench::measureAllocations([&]{ parser.parse(2, argv); }).count == 0);
+	}
+	SECTION("reparse command line")
+	{
+		const std::string line{"utility -a -i1 --sss='quoted value' \"operand\""};
+		parser.parseCommandLine(line);
+		REQUIRE(bench::measureAllocations([&]{ parser.parseCommandLine(line); }).count == 0);
+		REQUIRE(s == "quoted value");
+		REQUIRE(o == "operand");
+	}
+}
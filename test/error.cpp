@@ -4,6 +4,7 @@
 #include <vector>
 
 #include <minarg/minarg.hpp>
+#include <minarg/instances.hpp>
 
 
 TEST_CASE("error messages")
@@ -59,11 +60,57 @@ TEST_CASE("error messages")
 	}
 	SECTION("unkown short option")
 	{
-		REQUIRE_THROWS_WITH(parser.parse({"", "-x"}), "Unknown option name: x");
+		REQUIRE_THROWS_WITH(parser.parse({"", "-x"}), "Unknown option name: -x");
 	}
 	SECTION("unkown long option")
 	{
-		REQUIRE_THROWS_WITH(parser.parse({"", "--xx"}), "Unknown option name: xx");
+		REQUIRE_THROWS_WITH(parser.parse({"", "--xx"}), "Unknown option name: --xx");
+	}
+	SECTION("suggest similar long name")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "--is"}), "Unknown option name: --is (did you mean --ii, --ss?)");
+	}
+	SECTION("suggest closest long name")
+	{
+		int x{1};
+		parser.addOption(x, 0, "verbose", "", "");
+		parser.addOption(x, 0, "verbatim", "", "");
+		REQUIRE_THROWS_WITH(parser.parse({"", "--verbse"}), "Unknown option name: --verbse (did you mean --verbose?)");
+	}
+	SECTION("suggest among shared prefixes")
+	{
+		int x{1};
+		for (int i{0}; i < 1000; ++i)
+			parser.addOption(x, 0, "flag-" + std::to_string(i), "", "");
+		parser.addOption(x, 0, "flag-500-extra", "", "");
+		REQUIRE_THROWS_WITH(parser.parse({"", "--falg-500"}), "Unknown option name: --falg-500 (did you mean --flag-500?)");
+		REQUIRE_THROWS_WITH(parser.parse({"", "--flag-500-extr"}), "Unknown option name: --flag-500-extr (did you mean --flag-500-extra?)");
+		REQUIRE_THROWS_WITH(parser.parse({"", "--flag-5000"}), "Unknown option name: --flag-5000 (did you mean --flag-500?)");
+		REQUIRE_THROWS_WITH(parser.parse({"", "--flag-50x"}), "Unknown option name: --flag-50x (did you mean "
+			"--flag-50, --flag-500, --flag-501, --flag-502, --flag-503, --flag-504, --flag-505, "
+			"--flag-506, --flag-507, --flag-508, --flag-509?)");
+	}
+	SECTION("suggest with custom long prefix")
+	{
+		parser.setLongOptionPrefix("-");
+		REQUIRE_THROWS_WITH(parser.parse({"", "-is"}), "Unknown option name: -is (did you mean -ii, -ss?)");
+		parser.setLongOptionPrefix("+");
+		REQUIRE_THROWS_WITH(parser.parse({"", "+iii"}), "Unknown option name: +iii (did you mean +ii?)");
+	}
+	SECTION("suggest short name for long name")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "--i"}), "Unknown option name: --i (did you mean -i?)");
+	}
+	SECTION("suggest short name with different case")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "-I"}), "Unknown option name: -I (did you mean -i?)");
+	}
+	SECTION("ambiguous long option abbreviation")
+	{
+		bool x{false};
+		parser.addOption(x, 0, "ix", "");
+		parser.setLongOptionAbbreviation(true);
+		REQUIRE_THROWS_WITH(parser.parse({"", "--i"}), "Ambiguous option name: --i (--ii, --ix)");
 	}
 	SECTION("missing required boolean option (short name only)")
 	{
@@ -96,3 +143,182 @@ TEST_CASE("error messages")
 		REQUIRE_THROWS_WITH(parser.parse({""}), "Cannot find required argument: xx");
 	}
 }
+
+
+TEST_CASE("error collection")
+{
+	bool s{false};
+	int i{1};
+	int a{1};
+
+	minarg::Parser parser{};
+	parser.addOption(s, 's', "ss", "");
+	parser.addOption(i, 'i', "ii", "", "", true);
+	parser.addOperand(a, "aa", "", true);
+
+	SECTION("no errors")
+	{
+		auto errors = parser.validate({"", "-s", "-i", "2", "3"});
+		REQUIRE(errors.empty());
+		REQUIRE(s == true);
+		REQUIRE(i == 2);
+		REQUIRE(a == 3);
+	}
+	SECTION("all errors with argument index")
+	{
+		auto errors = parser.validate({"", "-x", "--ii=y", "-s", "--ss=1", "4", "5", "6"});
+		REQUIRE(errors.size() == 6);
+		REQUIRE(std::string{errors[0].what()} == "Unknown option name: -x");
+		REQUIRE(errors[0].index == 1);
+		REQUIRE(std::string{errors[1].what()} == "Cannot parse integer: y");
+		REQUIRE(errors[1].index == 2);
+		REQUIRE(std::string{errors[2].what()} == "Unexpected option value: --ss=1");
+		REQUIRE(errors[2].index == 4);
+		REQUIRE(std::string{errors[3].what()} == "Unexpected argument: 5");
+		REQUIRE(errors[3].index == 6);
+		REQUIRE(std::string{errors[4].what()} == "Unexpected argument: 6");
+		REQUIRE(errors[4].index == 7);
+		REQUIRE(std::string{errors[5].what()} == "Cannot find required argument: -i");
+		REQUIRE(errors[5].index == 8);
+		REQUIRE(s == true);
+		REQUIRE(a == 4);
+	}
+	SECTION("missing required arguments")
+	{
+		auto errors = parser.validate({""});
+		REQUIRE(errors.size() == 2);
+		REQUIRE(std::string{errors[0].what()} == "Cannot find required argument: -i");
+		REQUIRE(errors[0].index == 1);
+		REQUIRE(std::string{errors[1].what()} == "Cannot find required argument: aa");
+		REQUIRE(errors[1].index == 1);
+	}
+	SECTION("unexpected option between operands")
+	{
+		std::vector<int> b{};
+		parser.addOperandSink(b, "bb", "");
+		auto errors = parser.validate({"", "-i", "2", "3", "4", "-s", "5"});
+		REQUIRE(errors.size() == 1);
+		REQUIRE(std::string{errors[0].what()} == "Unexpected option: -s");
+		REQUIRE(errors[0].index == 5);
+		REQUIRE(b == std::vector<int>{4, 5});
+	}
+	SECTION("all errors of a command line")
+	{
+		auto errors = parser.validateCommandLine("utility -x --ii=y 'a'");
+		REQUIRE(errors.size() == 5);
+		REQUIRE(std::string{errors[0].what()} == "Unknown option name: -x");
+		REQUIRE(errors[0].index == 1);
+		REQUIRE(std::string{errors[1].what()} == "Cannot parse integer: y");
+		REQUIRE(errors[1].index == 2);
+		REQUIRE(std::string{errors[2].what()} == "Cannot parse integer: a");
+		REQUIRE(errors[2].index == 3);
+		REQUIRE(std::string{errors[3].what()} == "Cannot find required argument: -i");
+		REQUIRE(errors[3].index == 4);
+		REQUIRE(std::string{errors[4].what()} == "Cannot find required argument: aa");
+		REQUIRE(errors[4].index == 4);
+	}
+	SECTION("command line that cannot be split")
+	{
+		auto errors = parser.validateCommandLine("utility -s 'a");
+		REQUIRE(errors.size() == 1);
+		REQUIRE(errors[0].kind == minarg::Error::Kind::unclosedQuote);
+		REQUIRE(errors[0].argument == "'a");
+		REQUIRE(errors[0].index == 2);
+		REQUIRE(parser.validateCommandLine("utility -i 2 3").empty());
+	}
+	SECTION("repeated validation")
+	{
+		REQUIRE(parser.validate({"", "-i", "2", "--", "3"}).empty());
+		REQUIRE(parser.validate({""}).size() == 2);
+		REQUIRE(parser.validate({"", "-i", "2", "3"}).empty());
+	}
+	SECTION("index of thrown error")
+	{
+		try
+		{
+			parser.parse({"", "-s", "--ii", "x"});
+			FAIL();
+		}
+		catch (const minarg::Error& e)
+		{
+			REQUIRE(e.index == 2);
+		}
+	}
+	SECTION("signal is thrown")
+	{
+		parser.addSignal('h', "", "");
+		REQUIRE_THROWS_AS(parser.validate({"", "-x", "-h"}), minarg::Signal);
+	}
+}
+
+
+TEST_CASE("error details")
+{
+	int i{1};
+
+	minarg::Parser parser{};
+	parser.addOption(i, 'i', "ii", "", "");
+	parser.addOption(i,  0 , "ij", "", "");
+
+	using Kind = minarg::Error::Kind;
+
+	SECTION("invalid value")
+	{
+		auto errors = parser.validate({"", "-i", "x"});
+		REQUIRE(errors.size() == 1);
+		REQUIRE(errors[0].kind == Kind::invalidInteger);
+		REQUIRE(errors[0].argument == "x");
+		REQUIRE(errors[0].candidates.empty());
+	}
+	SECTION("unknown option with suggestions")
+	{
+		auto errors = parser.validate({"", "--ik"});
+		REQUIRE(errors.size() == 1);
+		REQUIRE(errors[0].kind == Kind::unknownOption);
+		REQUIRE(errors[0].argument == "--ik");
+		REQUIRE(errors[0].candidates == std::vector<std::string>{"--ii", "--ij"});
+	}
+	SECTION("unknown option without suggestions")
+	{
+		parser.setOptionSuggestions(false);
+		auto errors = parser.validate({"", "--ik", "-I"});
+		REQUIRE(errors.size() == 2);
+		REQUIRE(errors[0].kind == Kind::unknownOption);
+		REQUIRE(errors[0].argument == "--ik");
+		REQUIRE(errors[0].candidates.empty());
+		REQUIRE(errors[1].candidates.empty());
+		REQUIRE(std::string{errors[0].what()} == "Unknown option name: --ik");
+	}
+	SECTION("ambiguous option")
+	{
+		parser.setLongOptionAbbreviation(true);
+		auto errors = parser.validate({"", "--i=2"});
+		REQUIRE(errors.size() == 1);
+		REQUIRE(errors[0].kind == Kind::ambiguousOption);
+		REQUIRE(errors[0].argument == "--i");
+		REQUIRE(errors[0].candidates == std::vector<std::string>{"--ii", "--ij"});
+	}
+	SECTION("custom message")
+	{
+		minarg::Error error{"Custom"};
+		REQUIRE(error.kind == Kind::custom);
+		REQUIRE(std::string{error.what()} == "Custom");
+	}
+	SECTION("message is cached")
+	{
+		minarg::Error error{Kind::unexpectedArgument, "x"};
+		const char* message{error.what()};
+		REQUIRE(std::string{message} == "Unexpected argument: x");
+		REQUIRE(error.what() == message);
+	}
+	SECTION("copies keep the cached message")
+	{
+		minarg::Error error{Kind::unexpectedArgument, "x"};
+		const minarg::Error unformatted{error};
+		const std::string message{error.what()};
+		const minarg::Error formatted{error};
+		REQUIRE(formatted.what() == message);
+		REQUIRE(unformatted.what() == message);
+		REQUIRE(minarg::Error{minarg::Error{"Custom"}}.what() == std::string{"Custom"});
+	}
+}
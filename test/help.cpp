@@ -6,6 +6,7 @@
 #include <vector>
 
 #include <minarg/minarg.hpp>
+#include <minarg/instances.hpp>
 
 
 TEST_CASE("signal")
@@ -275,6 +276,20 @@ TEST_CASE("help message formatting")
 			"    CCCC    Cc\n"
 			"\n");
 	}
+	SECTION("option sink")
+	{
+		parser.addOptionSink(sink, 'i', "ids", "ID,...", "Ii", ',');
+		parser.addOptionSink(sink, 'r', "", "RR", "Rr", 0, true);
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  hello [-i ID,...]... -r RR...\n"
+			"\n"
+			"OPTIONS\n"
+			"  -i, --ids ID,...  Ii\n"
+			"  -r RR             Rr\n"
+			"\n");
+	}
 }
 
 
@@ -384,6 +399,88 @@ TEST_CASE("help message with default values")
 			"  II  Ii (Hello:2)\n"
 			"\n");
 	}
+	SECTION("print default value after parsing")
+	{
+		int i{2};
+		std::string s{"s"};
+		parser.addOperand(i, "II", "");
+		parser.addOperand(s, "SS", "");
+		parser.parse({"", "3", "t"});
+		parser.parse({"", "4", "u"});
+		stream << parser;
+		REQUIRE(i == 4);
+		REQUIRE(s == "u");
+		REQUIRE(stream.str() ==
+			"OPERANDS\n"
+			"  II  (default: 2)\n"
+			"  SS  (default: \"s\")\n"
+			"\n");
+	}
+	SECTION("print default value of shared target")
+	{
+		int i{1};
+		std::string s{"s"};
+		parser.addOperand(i, "I1", "");
+		parser.addOperand(i, "I2", "");
+		parser.addOperand(s, "S1", "");
+		parser.addOperand(s, "S2", "");
+		parser.parse({"", "5", "6", "t", "u"});
+		stream << parser;
+		REQUIRE(i == 6);
+		REQUIRE(s == "u");
+		REQUIRE(stream.str() ==
+			"OPERANDS\n"
+			"  I1  (default: 1)\n"
+			"  I2  (default: 1)\n"
+			"  S1  (default: \"s\")\n"
+			"  S2  (default: \"s\")\n"
+			"\n");
+	}
+	SECTION("print default value of unparsed alias")
+	{
+		int i{1};
+		parser.addOperand(i, "I1", "");
+		parser.addOperand(i, "I2", "");
+		parser.parse({"", "5"});
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"OPERANDS\n"
+			"  I1  (default: 1)\n"
+			"  I2  (default: 1)\n"
+			"\n");
+	}
+	SECTION("print default value changed before parsing")
+	{
+		int i{1};
+		std::string s{"initial"};
+		parser.addOperand(s, "SS", "");
+		parser.addOperand(i, "II", "");
+		s = "changed";
+		i = 2;
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"OPERANDS\n"
+			"  SS  (default: \"changed\")\n"
+			"  II  (default: 2)\n"
+			"\n");
+	}
+	SECTION("print default value changed between parses")
+	{
+		int i{1};
+		std::string s{"initial"};
+		parser.addOperand(s, "SS", "");
+		parser.addOperand(i, "II", "");
+		parser.parse({""});
+		s = "changed";
+		i = 2;
+		parser.parse({"", "t", "3"});
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"OPERANDS\n"
+			"  SS  (default: \"changed\")\n"
+			"  II  (default: 2)\n"
+			"\n");
+	}
 	SECTION("disabled default")
 	{
 		int i{2};
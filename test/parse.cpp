@@ -1,9 +1,14 @@
 #include <catch2/catch.hpp>
 
+#include <list>
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <minarg/minarg.hpp>
+#include <minarg/instances.hpp>
 
 
 TEST_CASE("argv is char**")
@@ -574,6 +579,102 @@ TEST_CASE("prefix precedence")
 }
 
 
+TEST_CASE("option name lookup")
+{
+	bool a{false};
+	bool ab{false};
+	bool abc{false};
+
+	minarg::Parser parser{};
+	parser.addOption(a  , 'a', "a"  , "");
+	parser.addOption(ab , 'b', "ab" , "");
+	parser.addOption(abc, 'c', "abc", "");
+
+	SECTION("names share a common prefix")
+	{
+		parser.parse({"", "--ab"});
+		REQUIRE(a   == false);
+		REQUIRE(ab  == true);
+		REQUIRE(abc == false);
+	}
+	SECTION("name is prefix of registered name")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "--abcd"}), "Unknown option name: --abcd (did you mean --abc?)");
+	}
+	SECTION("name diverges after common prefix")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "--ax=1"}), "Unknown option name: --ax (did you mean --a, --ab?)");
+	}
+	SECTION("first of duplicate names takes precedence")
+	{
+		bool x{false};
+		parser.addOption(x, 'a', "abc", "");
+		parser.parse({"", "-a", "--abc"});
+		REQUIRE(a   == true);
+		REQUIRE(abc == true);
+		REQUIRE(x   == false);
+	}
+	SECTION("option added after parsing")
+	{
+		bool x{false};
+		parser.parse({"", "-a"});
+		parser.addOption(x, 'x', "xx", "");
+		parser.parse({"", "-x", "--xx"});
+		REQUIRE(x == true);
+	}
+}
+
+
+TEST_CASE("long option abbreviation")
+{
+	bool verb{false};
+	bool verbose{false};
+	bool verbatim{false};
+	int quiet{1};
+
+	minarg::Parser parser{};
+	parser.addOption(verb    , 0, "verb"    , "");
+	parser.addOption(verbose , 0, "verbose" , "");
+	parser.addOption(verbatim, 0, "verbatim", "");
+	parser.addOption(quiet   , 0, "quiet"   , "", "");
+
+	SECTION("disabled by default")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "--verbo"}), minarg::Error);
+	}
+	SECTION("unique prefix")
+	{
+		parser.setLongOptionAbbreviation(true);
+		parser.parse({"", "--verbo", "--q=2"});
+		REQUIRE(verbose == true);
+		REQUIRE(quiet == 2);
+	}
+	SECTION("exact match takes precedence")
+	{
+		parser.setLongOptionAbbreviation(true);
+		parser.parse({"", "--verb"});
+		REQUIRE(verb == true);
+		REQUIRE(verbose == false);
+	}
+	SECTION("ambiguous prefix")
+	{
+		parser.setLongOptionAbbreviation(true);
+		REQUIRE_THROWS_AS(parser.parse({"", "--verba", "--ver"}), minarg::Error);
+		REQUIRE(verbatim == true);
+	}
+	SECTION("unknown prefix")
+	{
+		parser.setLongOptionAbbreviation(true);
+		REQUIRE_THROWS_AS(parser.parse({"", "--verbx"}), minarg::Error);
+	}
+	SECTION("empty name")
+	{
+		parser.setLongOptionAbbreviation(true);
+		REQUIRE_THROWS_AS(parser.parse({"", "--=2"}), minarg::Error);
+	}
+}
+
+
 TEST_CASE("value precedence")
 {
 	bool s{false};
@@ -605,3 +706,505 @@ TEST_CASE("value precedence")
 		REQUIRE(s == false);
 	}
 }
+
+
+TEST_CASE("command line")
+{
+	bool a{false};
+	std::string s{"s"};
+	std::vector<std::string> o{};
+
+	minarg::Parser parser{};
+	parser.addOption(a, 'a', ""   , "");
+	parser.addOption(s, 's', "sss", "", "");
+	parser.addOperandSink(o, "", "");
+
+	SECTION("empty")
+	{
+		parser.parseCommandLine("");
+		REQUIRE(a == false);
+		REQUIRE(o.empty());
+	}
+	SECTION("plain words")
+	{
+		parser.parseCommandLine("  utility\t-a  x\ny ");
+		REQUIRE(a == true);
+		REQUIRE(o == std::vector<std::string>{"x", "y"});
+	}
+	SECTION("single quotes")
+	{
+		parser.parseCommandLine("utility -s 'a \"b\" \\c' ''");
+		REQUIRE(s == "a \"b\" \\c");
+		REQUIRE(o == std::vector<std::string>{""});
+	}
+	SECTION("double quotes")
+	{
+		parser.parseCommandLine("utility -s \"a 'b' \\\"c\\\" \\d\" \"\"");
+		REQUIRE(s == "a 'b' \"c\" \\d");
+		REQUIRE(o == std::vector<std::string>{""});
+	}
+	SECTION("backslash escapes")
+	{
+		parser.parseCommandLine("utility -s a\\ b\\\\ \\\n x\\\ny");
+		REQUIRE(s == "a b\\");
+		REQUIRE(o == std::vector<std::string>{"xy"});
+	}
+	SECTION("quotes within a word")
+	{
+		parser.parseCommandLine("utility --sss='a b'\"c d\"e");
+		REQUIRE(s == "a bc de");
+	}
+	SECTION("quoted short option value")
+	{
+		parser.parseCommandLine("utility -as\" \"");
+		REQUIRE(a == true);
+		REQUIRE(s == " ");
+	}
+	SECTION("quoted terminator")
+	{
+		parser.parseCommandLine("utility '--' -a");
+		REQUIRE(a == false);
+		REQUIRE(o == std::vector<std::string>{"-a"});
+	}
+	SECTION("mixed plain and quoted words")
+	{
+		parser.parseCommandLine("utility --sss='long quoted value' 'x x' y \"z\"z w\\ w v 'u'");
+		REQUIRE(s == "long quoted value");
+		REQUIRE(o == std::vector<std::string>{"x x", "y", "zz", "w w", "v", "u"});
+		parser.parseCommandLine("u 't'");
+		REQUIRE(o == std::vector<std::string>{"x x", "y", "zz", "w w", "v", "u", "t"});
+	}
+	SECTION("missing closing single quote")
+	{
+		REQUIRE_THROWS_WITH(parser.parseCommandLine("utility -a 'b c"), "Cannot find closing quote: 'b c");
+	}
+	SECTION("missing closing double quote")
+	{
+		REQUIRE_THROWS_WITH(parser.parseCommandLine("utility -a \"b\\\""), "Cannot find closing quote: \"b\\\"");
+	}
+	SECTION("missing escaped character")
+	{
+		REQUIRE_THROWS_WITH(parser.parseCommandLine("utility -a b\\"), "Cannot find escaped character: b\\");
+	}
+}
+
+
+TEST_CASE("option sink")
+{
+	std::vector<int> i{};
+	std::vector<std::string> s{};
+
+	minarg::Parser parser{};
+	parser.addOptionSink(i, 'i', "ii", "", "", ',');
+	parser.addOptionSink(s, 's', "ss", "", "", 0);
+
+	SECTION("none")
+	{
+		parser.parse({""});
+		REQUIRE(i.empty());
+		REQUIRE(s.empty());
+	}
+	SECTION("repeated occurrences")
+	{
+		parser.parse({"", "-s", "a", "--ss=b,c", "-sd", "--ss", ""});
+		REQUIRE(s == std::vector<std::string>{"a", "b,c", "d", ""});
+	}
+	SECTION("delimited list")
+	{
+		parser.parse({"", "--ii=1,2,3"});
+		REQUIRE(i == std::vector<int>{1, 2, 3});
+	}
+	SECTION("repeated delimited lists")
+	{
+		parser.parse({"", "-i", "1,2", "-i3", "--ii", "4,5,6"});
+		REQUIRE(i == std::vector<int>{1, 2, 3, 4, 5, 6});
+	}
+	SECTION("preserved pre-existing elements")
+	{
+		i = {0};
+		parser.parse({"", "-i", "1,2"});
+		REQUIRE(i == std::vector<int>{0, 1, 2});
+	}
+	SECTION("long delimited list")
+	{
+		std::string list{"0"};
+		for (int n{1}; n < 10000; ++n)
+			list += "," + std::to_string(n);
+		parser.parse({"", "-i", list});
+		REQUIRE(i.size() == 10000);
+		REQUIRE(i.back() == 9999);
+	}
+	SECTION("container without reserve")
+	{
+		std::list<int> l{};
+		parser.addOptionSink(l, 'l', "", "", "", ':');
+		parser.parse({"", "-l", "1:2", "-l3"});
+		REQUIRE(l == std::list<int>{1, 2, 3});
+	}
+	SECTION("empty element")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-i", "1,,2"}), minarg::Error);
+	}
+	SECTION("trailing delimiter")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-i", "1,"}), minarg::Error);
+	}
+	SECTION("required")
+	{
+		std::vector<int> r{};
+		parser.addOptionSink(r, 'r', "", "", "", ',', true);
+		REQUIRE_THROWS_AS(parser.parse({""}), minarg::Error);
+	}
+}
+
+
+TEST_CASE("option map")
+{
+	std::unordered_map<std::string, std::string> d{};
+	std::map<int, int> m{};
+
+	minarg::Parser parser{};
+	parser.addOptionMap(d, 'D', "define", "", "");
+	parser.addOptionMap(m, 'm', "", "", "", ':');
+
+	SECTION("none")
+	{
+		parser.parse({""});
+		REQUIRE(d.empty());
+		REQUIRE(m.empty());
+	}
+	SECTION("key value pairs")
+	{
+		parser.parse({"", "-D", "a=1", "-Db=2", "--define=c=3", "--define", "d="});
+		REQUIRE(d == std::unordered_map<std::string, std::string>{
+			{"a", "1"}, {"b", "2"}, {"c", "3"}, {"d", ""}});
+	}
+	SECTION("converted keys and values")
+	{
+		parser.parse({"", "-m", "1:10", "-m2:0x20"});
+		REQUIRE(m == std::map<int, int>{{1, 10}, {2, 32}});
+	}
+	SECTION("value contains separator")
+	{
+		parser.parse({"", "-D", "a=b=c"});
+		REQUIRE(d.at("a") == "b=c");
+	}
+	SECTION("duplicate key")
+	{
+		parser.parse({"", "-D", "a=1", "-D", "a=2"});
+		REQUIRE(d.size() == 1);
+		REQUIRE(d.at("a") == "2");
+	}
+	SECTION("preserved pre-existing entries")
+	{
+		d = {{"x", "y"}};
+		parser.parse({"", "-D", "a=1"});
+		REQUIRE(d.size() == 2);
+	}
+	SECTION("many pairs")
+	{
+		std::vector<std::string> argv{""};
+		for (int i{0}; i < 1000; ++i)
+		{
+			argv.push_back("-m");
+			argv.push_back(std::to_string(i) + ":" + std::to_string(i));
+		}
+		argv.push_back("-D");
+		argv.push_back("a=1");
+		parser.parse(argv);
+		REQUIRE(m.size() == 1000);
+		REQUIRE(d.size() == 1);
+	}
+	SECTION("buckets reserved for all pairs")
+	{
+		std::vector<std::string> argv{""};
+		for (int i{0}; i < 100; ++i)
+		{
+			argv.push_back("-D");
+			argv.push_back(std::to_string(i) + "=");
+			argv.push_back("--define=x" + std::to_string(i) + "=");
+		}
+		argv.push_back("-m1:1");
+
+		std::unordered_map<std::string, std::string> reserved{};
+		reserved.reserve(200);
+		parser.parse(argv);
+		REQUIRE(d.size() == 200);
+		REQUIRE(d.bucket_count() == reserved.bucket_count());
+	}
+	SECTION("missing separator")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "-D", "a"}), "Cannot parse value: a");
+	}
+	SECTION("invalid key")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-m", "x:1"}), minarg::Error);
+	}
+	SECTION("invalid value")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-m", "1:x"}), minarg::Error);
+	}
+}
+
+
+TEST_CASE("trusted arguments")
+{
+	bool a{false};
+	int i{1};
+	std::vector<int> o{};
+
+	minarg::Parser parser{};
+	parser.setTrusted(true);
+	parser.addOption(a, 'a', "aaa", "");
+	parser.addOption(i, 'i', "iii", "", "", true);
+	parser.addOperandSink(o, "", "", true);
+
+	SECTION("valid arguments")
+	{
+		parser.parse({"", "-a", "--iii=2", "3", "--", "4"});
+		REQUIRE(a == true);
+		REQUIRE(i == 2);
+		REQUIRE(o == std::vector<int>{3, 4});
+	}
+	SECTION("observer sees the trusted parse")
+	{
+		minarg::Counters counters{};
+		parser.setObserver(&counters);
+		parser.parse({"", "-a", "--iii=2", "3", "--", "4"});
+		REQUIRE(counters.getErrors() == 0);
+
+		minarg::Counters untrusted{};
+		parser.setTrusted(false);
+		parser.setObserver(&untrusted);
+		parser.parse({"", "-a", "--iii=2", "3", "--", "4"});
+		REQUIRE(counters.getTokens() == untrusted.getTokens());
+		REQUIRE(counters.getLookups() == untrusted.getLookups());
+		REQUIRE(counters.getConversions() == untrusted.getConversions());
+		REQUIRE(untrusted.getErrors() == 0);
+	}
+	SECTION("unknown option")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-x"}), minarg::Error);
+	}
+	SECTION("no suggestions for unknown option")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "--aab"}), "Unknown option name: --aab");
+	}
+	SECTION("missing value")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-i"}), minarg::Error);
+	}
+	SECTION("invalid value")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-i", "x"}), minarg::Error);
+	}
+	SECTION("validation runs all checks")
+	{
+		auto errors = parser.validate({"", "-a"});
+		REQUIRE(errors.size() == 2);
+	}
+}
+
+
+TEST_CASE("option permutation")
+{
+	bool a{false};
+	int i{1};
+	std::string s{};
+	std::vector<std::string> o{};
+
+	minarg::Parser parser{};
+	parser.setOptionPermutation(true);
+	parser.addOption(a, 'a', "aaa", "");
+	parser.addOption(i, 'i', "iii", "", "");
+
+	SECTION("operands before options")
+	{
+		parser.addOperand(s, "", "");
+		parser.addOperandSink(o, "", "");
+		parser.parse({"", "x", "-a", "y", "--iii", "2", "z"});
+		REQUIRE(a == true);
+		REQUIRE(i == 2);
+		REQUIRE(s == "x");
+		REQUIRE(o == std::vector<std::string>{"y", "z"});
+	}
+	SECTION("operands after terminator")
+	{
+		parser.addOperand(s, "", "");
+		parser.addOperandSink(o, "", "");
+		parser.parse({"", "x", "-a", "--", "-i", "y"});
+		REQUIRE(a == true);
+		REQUIRE(i == 1);
+		REQUIRE(s == "x");
+		REQUIRE(o == std::vector<std::string>{"-i", "y"});
+	}
+	SECTION("option value is not an operand")
+	{
+		parser.addOperand(s, "", "");
+		parser.parse({"", "-i", "3", "x"});
+		REQUIRE(i == 3);
+		REQUIRE(s == "x");
+	}
+	SECTION("unexpected operand")
+	{
+		parser.addOperand(s, "", "");
+		REQUIRE_THROWS_WITH(parser.parse({"", "x", "-a", "y"}), "Unexpected argument: y");
+	}
+	SECTION("disabled")
+	{
+		parser.setOptionPermutation(false);
+		parser.addOperandSink(o, "", "");
+		REQUIRE_THROWS_WITH(parser.parse({"", "x", "-a"}), "Unexpected option: -a");
+	}
+	SECTION("reparse")
+	{
+		parser.addOperand(s, "", "");
+		parser.parse({"", "-a", "x"});
+		parser.parse({"", "y", "-a"});
+		REQUIRE(s == "y");
+	}
+}
+
+
+TEST_CASE("observer")
+{
+	bool a{false};
+	int i{0};
+	std::vector<std::string> o{};
+
+	minarg::Parser parser{};
+	parser.addOption(a, 'a', "", "");
+	parser.addOption(i, 'i', "iii", "", "");
+	parser.addOperandSink(o, "", "");
+
+	SECTION("phases")
+	{
+		struct Phases : minarg::Observer
+		{
+			std::vector<Phase> phases{};
+			void onPhase(Phase p) override { phases.push_back(p); }
+		} observer{};
+
+		using Phase = minarg::Observer::Phase;
+		parser.setObserver(&observer);
+		parser.parse({"", "-a"});
+		REQUIRE(observer.phases == std::vector<Phase>{
+			Phase::setup, Phase::utility, Phase::options,
+			Phase::operands, Phase::checks, Phase::done});
+	}
+	SECTION("counters")
+	{
+		minarg::Counters counters{};
+		parser.setObserver(&counters);
+		parser.parse({"", "-ai1", "--iii", "2", "--iii=3", "x", "y"});
+		REQUIRE(counters.getTokens() == 5);
+		REQUIRE(counters.getLookups() == 4);
+		REQUIRE(counters.getConversions() == 5);
+		REQUIRE(counters.getErrors() == 0);
+		REQUIRE(counters.getHits() == std::map<std::string, std::size_t>{{"a", 1}, {"iii", 3}});
+
+		parser.validate({"", "-b", "--iii=x", "x", "-a"});
+		REQUIRE(counters.getErrors() == 3);
+		REQUIRE(counters.getErrors(minarg::Error::Kind::unknownOption) == 1);
+		REQUIRE(counters.getErrors(minarg::Error::Kind::invalidInteger) == 1);
+		REQUIRE(counters.getErrors(minarg::Error::Kind::unexpectedOption) == 1);
+		REQUIRE(counters.getErrors(minarg::Error::Kind::invalidChoice) == 0);
+
+		counters.clear();
+		REQUIRE(counters.getTokens() == 0);
+		REQUIRE(counters.getHits().empty());
+	}
+	SECTION("command line errors")
+	{
+		minarg::Counters counters{};
+		parser.setObserver(&counters);
+		REQUIRE_THROWS_AS(parser.parseCommandLine("utility -a 'x"), minarg::Error);
+		REQUIRE(counters.getErrors(minarg::Error::Kind::unclosedQuote) == 1);
+	}
+	SECTION("token views")
+	{
+		struct Tokens : minarg::Observer
+		{
+			std::vector<std::string> tokens{};
+			void onToken(const char* first, const char* last) override { tokens.emplace_back(first, last); }
+		} observer{};
+
+		parser.setObserver(&observer);
+		parser.parseCommandLine("utility -a --iii 2 'x y'");
+		REQUIRE(observer.tokens == std::vector<std::string>{"-a", "--iii", "x y"});
+	}
+	SECTION("removed observer")
+	{
+		minarg::Counters counters{};
+		parser.setObserver(&counters);
+		parser.setObserver(nullptr);
+		parser.parse({"", "-a"});
+		REQUIRE(counters.getTokens() == 0);
+	}
+}
+
+
+TEST_CASE("footprint and freeze")
+{
+	bool a{false};
+	int i{0};
+	std::string s{};
+	std::vector<std::string> v{};
+	int c{0};
+
+	minarg::Parser parser{"A long prolog that does not fit into the inline storage of a string"};
+	parser.addOption(a, 'a', "", "");
+	parser.addOption(i, 'i', "iii", "I", "");
+	parser.addOption(s, 0, "a-long-option-name-for-the-index", "S", "");
+	parser.addOption(c, 'c', "ccc", "C", "", {{"choice-a", 1}, {"choice-b", 2}});
+	parser.addOperandSink(v, "V", "");
+
+	const minarg::Footprint before{parser.getFootprint()};
+	REQUIRE(before.parser >= sizeof(minarg::Parser));
+	REQUIRE(before.arguments > 0);
+	REQUIRE(before.names > 0);
+	REQUIRE(before.defaults > 0);
+	REQUIRE(before.choices > 0);
+	REQUIRE(before.getTotal() == before.parser + before.arguments + before.names
+		+ before.defaults + before.choices + before.index + before.buffers);
+
+	REQUIRE_FALSE(parser.isFrozen());
+	parser.freeze();
+	REQUIRE(parser.isFrozen());
+
+	const minarg::Footprint after{parser.getFootprint()};
+	REQUIRE(after.index > 0);
+	REQUIRE(after.arguments <= before.arguments);
+	REQUIRE(after.choices <= before.choices);
+	REQUIRE(after.names <= before.names);
+
+	SECTION("short name table only with short names")
+	{
+		bool b{false};
+		minarg::Parser longOnly{};
+		longOnly.addOption(b, 0, "bbb", "");
+		longOnly.freeze();
+
+		minarg::Parser withShort{};
+		withShort.addOption(b, 'b', "bbb", "");
+		withShort.freeze();
+
+		REQUIRE(withShort.getFootprint().index - longOnly.getFootprint().index == 256 * sizeof(void*));
+	}
+	SECTION("add after freeze")
+	{
+		REQUIRE_THROWS_AS(parser.addOption(a, 'b', "", ""), std::logic_error);
+		REQUIRE_THROWS_AS(parser.addOperand(s, "S", ""), std::logic_error);
+		REQUIRE_THROWS_AS(parser.addOperandSink(v, "V", ""), std::logic_error);
+	}
+	SECTION("parse after freeze")
+	{
+		parser.parse({"", "-a", "--iii=3", "--a-long-option-name-for-the-index", "x", "--ccc=choice-b", "y"});
+		REQUIRE(a);
+		REQUIRE(i == 3);
+		REQUIRE(s == "x");
+		REQUIRE(c == 2);
+		REQUIRE(v == std::vector<std::string>{"y"});
+		REQUIRE(parser.getFootprint().index == after.index);
+	}
+}
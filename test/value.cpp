@@ -6,7 +6,78 @@
 #include <sstream>
 #include <string>
 
+#include <map>
+#include <vector>
+
 #include <minarg/minarg.hpp>
+#include <minarg/instances.hpp>
+
+
+// The string converter must be visible in the whole program, so
+// it is tested in minarg-test-string, which only compiles this file.
+// It keeps the conversion of the other tests, but counts the calls.
+
+#if defined(MINARG_TEST_STRING_CONVERTER)
+
+namespace {
+
+std::size_t stringConversions{0};
+bool isStringRejected{false};
+
+} // namespace
+
+
+namespace minarg {
+
+template<>
+struct Converter<std::string>
+{
+	static bool parse(const char* first, const char* last, std::string& s)
+	{
+		++stringConversions;
+		s.assign(first, last);
+		return !isStringRejected;
+	}
+};
+
+} // namespace minarg
+
+
+TEST_CASE("custom converter for strings")
+{
+	std::string s{};
+	std::vector<std::string> v{};
+	std::map<std::string, std::string> m{};
+	std::string o{};
+
+	minarg::Parser parser{};
+	parser.addOption(s, 's', "", "", "");
+	parser.addOptionSink(v, 'v', "", "", "", ',');
+	parser.addOptionMap(m, 'm', "", "", "");
+	parser.addOperand(o, "", "");
+
+	stringConversions = 0;
+	isStringRejected = false;
+
+	SECTION("all string targets")
+	{
+		parser.parse({"", "-s", "a", "-v", "b,c", "-m", "d=e", "f"});
+		REQUIRE(stringConversions == 6);
+		REQUIRE(s == "a");
+		REQUIRE(v == std::vector<std::string>{"b", "c"});
+		REQUIRE(m == std::map<std::string, std::string>{{"d", "e"}});
+		REQUIRE(o == "f");
+	}
+	SECTION("rejected value")
+	{
+		isStringRejected = true;
+		REQUIRE_THROWS_WITH(parser.parse({"", "-s", "a"}), "Cannot parse value: a");
+		isStringRejected = false;
+		REQUIRE(stringConversions == 1);
+	}
+}
+
+#endif
 
 
 // ---- String ----
@@ -41,6 +112,22 @@ TEST_CASE("string value")
 		REQUIRE(s == "s \t s");
 		REQUIRE(o == "o");
 	}
+#if !defined(MINARG_TEST_STRING_CONVERTER)
+	SECTION("reuse capacity of target")
+	{
+		parser.parse({"", "-s", std::string(100, 'a')});
+		const char* data{s.data()};
+		parser.parse({"", "-s", std::string(50, 'b')});
+		REQUIRE(s == std::string(50, 'b'));
+		REQUIRE(s.data() == data);
+	}
+#endif
+	SECTION("merged long value")
+	{
+		parser.addOption(s, 0, "ss", "", "");
+		parser.parse({"", "--ss=" + std::string(100, 'c'), "--ss=d=e"});
+		REQUIRE(s == "d=e");
+	}
 	SECTION("stand-alone option prefix")
 	{
 		parser.parse({"", "-s", "-", "-"});
@@ -544,3 +631,321 @@ TEST_CASE("custom value type")
 		REQUIRE_THROWS_AS(parser.parse({"", "-y", "ja"}), minarg::Error);
 	}
 }
+
+
+struct Hex
+{
+	int value{0};
+};
+
+
+std::istream& operator>>(std::istream& stream, Hex& h)
+{
+	return stream >> std::hex >> h.value;
+}
+
+
+std::ostream& operator<<(std::ostream& stream, const Hex& h)
+{
+	return stream << std::hex << std::showbase << h.value;
+}
+
+
+TEST_CASE("reused conversion streams")
+{
+	Hex h{};
+	float f{1.0f};
+
+	minarg::Parser parser{};
+	parser.addOption(h, 'h', "", "", "");
+	parser.addOption(f, 'f', "", "", "");
+
+	SECTION("repeated custom values")
+	{
+		parser.parse({"", "-h", "ff", "-f", "2.5"});
+		REQUIRE(h.value == 255);
+		REQUIRE(f == 2.5f);
+		parser.parse({"", "-h", "10"});
+		REQUIRE(h.value == 16);
+	}
+	SECTION("stream format does not leak")
+	{
+		parser.parse({"", "-h", "a", "-f", "10"});
+		REQUIRE(h.value == 10);
+		REQUIRE(f == 10.0f);
+	}
+	SECTION("trailing whitespace")
+	{
+		parser.parse({"", "-f", "0.5 \t"});
+		REQUIRE(f == 0.5f);
+	}
+	SECTION("invalid value after valid value")
+	{
+		parser.parse({"", "-f", "1"});
+		REQUIRE_THROWS_AS(parser.parse({"", "-f", "x"}), minarg::Error);
+		parser.parse({"", "-f", "2"});
+		REQUIRE(f == 2.0f);
+	}
+	SECTION("print default values")
+	{
+		h.value = 255;
+		minarg::Parser other{};
+		other.addOption(h, 'h', "", "H", "");
+		other.addOption(f, 'f', "", "F", "");
+
+		std::ostringstream stream{};
+		stream << other;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  [-h H] [-f F]\n"
+			"\n"
+			"OPTIONS\n"
+			"  -h H  (default: 0xff)\n"
+			"  -f F  (default: 1)\n"
+			"\n");
+	}
+}
+
+
+// ---- Custom converter ----
+
+struct Seconds
+{
+	long value{0};
+};
+
+
+namespace minarg {
+
+template<>
+struct Converter<Seconds>
+{
+	static bool parse(const char* first, const char* last, Seconds& s)
+	{
+		if (last - first < 2 || (last[-1] != 's' && last[-1] != 'm'))
+			return false;
+
+		long value{0};
+		for (const char* it{first}; it != last - 1; ++it)
+		{
+			if (*it < '0' || *it > '9')
+				return false;
+			value = value*10 + (*it - '0');
+		}
+
+		s.value = last[-1] == 'm' ? value*60 : value;
+		return true;
+	}
+
+	static std::string format(const Seconds& s)
+	{
+		return std::to_string(s.value) + 's';
+	}
+};
+
+} // namespace minarg
+
+
+TEST_CASE("custom converter")
+{
+	Seconds s{};
+	s.value = 30;
+
+	minarg::Parser parser{};
+	parser.addOption(s, 's', "", "SS", "Ss");
+
+	SECTION("valid value")
+	{
+		parser.parse({"", "-s", "2m"});
+		REQUIRE(s.value == 120);
+	}
+	SECTION("merged value")
+	{
+		parser.parse({"", "-s15s"});
+		REQUIRE(s.value == 15);
+	}
+	SECTION("invalid value")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "-s", "2h"}), "Cannot parse value: 2h");
+	}
+	SECTION("print default")
+	{
+		std::ostringstream stream{};
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  [-s SS]\n"
+			"\n"
+			"OPTIONS\n"
+			"  -s SS  Ss (default: 30s)\n"
+			"\n");
+	}
+}
+
+
+// The compiled tests define MINARG_NO_INSTANCE_UNSIGNED_SHORT
+
+namespace minarg {
+
+template<>
+struct Converter<unsigned short>
+{
+	static bool parse(const char* first, const char* last, unsigned short& port)
+	{
+		if (std::string{first, last} == "http")
+		{
+			port = 80;
+			return true;
+		}
+
+		unsigned long value{0};
+		for (const char* it{first}; it != last; ++it)
+		{
+			if (*it < '0' || *it > '9' || value > 6553)
+				return false;
+			value = value*10 + static_cast<unsigned long>(*it - '0');
+		}
+
+		port = static_cast<unsigned short>(value);
+		return first != last && value <= 65535;
+	}
+
+	static std::string format(const unsigned short& port)
+	{
+		return ':' + std::to_string(port);
+	}
+};
+
+} // namespace minarg
+
+
+TEST_CASE("custom converter for a common type")
+{
+	unsigned short p{8080};
+
+	minarg::Parser parser{};
+	parser.addOption(p, 'p', "", "PP", "Pp");
+
+	SECTION("name")
+	{
+		parser.parse({"", "-p", "http"});
+		REQUIRE(p == 80);
+	}
+	SECTION("number")
+	{
+		parser.parse({"", "-p", "443"});
+		REQUIRE(p == 443);
+	}
+	SECTION("invalid value")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "-p", "0x50"}), "Cannot parse value: 0x50");
+		REQUIRE_THROWS_WITH(parser.parse({"", "-p", "65536"}), "Cannot parse value: 65536");
+	}
+	SECTION("print default")
+	{
+		std::ostringstream stream{};
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  [-p PP]\n"
+			"\n"
+			"OPTIONS\n"
+			"  -p PP  Pp (default: :8080)\n"
+			"\n");
+	}
+}
+
+
+// ---- Choices ----
+
+enum class Mode
+{
+	fast,
+	safe,
+	audit
+};
+
+
+TEST_CASE("choice value")
+{
+	Mode m{Mode::safe};
+
+	minarg::Parser parser{};
+	parser.addOption(m, 'm', "mode", "MODE", "Mm", {
+		{"fast" , Mode::fast},
+		{"safe" , Mode::safe},
+		{"audit", Mode::audit}});
+
+	SECTION("valid choice")
+	{
+		parser.parse({"", "-m", "audit"});
+		REQUIRE(m == Mode::audit);
+		parser.parse({"", "--mode=fast"});
+		REQUIRE(m == Mode::fast);
+	}
+	SECTION("invalid choice")
+	{
+		REQUIRE_THROWS_WITH(parser.parse({"", "-m", "slow"}),
+			"Cannot parse choice: slow (expected fast, safe, audit)");
+	}
+	SECTION("invalid choice after the parser")
+	{
+		std::vector<minarg::Error> errors{};
+		{
+			minarg::Parser other{};
+			other.addOption(m, 'm', "", "", "", {{"fast", Mode::fast}, {"safe", Mode::safe}});
+			errors = other.validate({"", "-m", "slow"});
+		}
+		REQUIRE(errors.size() == 1);
+		REQUIRE(errors[0].kind == minarg::Error::Kind::invalidChoice);
+		REQUIRE(errors[0].candidates.empty());
+		REQUIRE(std::string{errors[0].what()} == "Cannot parse choice: slow (expected fast, safe)");
+	}
+	SECTION("choice is case sensitive")
+	{
+		REQUIRE_THROWS_AS(parser.parse({"", "-m", "Fast"}), minarg::Error);
+	}
+	SECTION("alias for the same value")
+	{
+		parser.addOption(m, 'a', "", "", "", {{"quick", Mode::fast}, {"fast", Mode::fast}});
+		parser.parse({"", "-a", "quick"});
+		REQUIRE(m == Mode::fast);
+
+		std::ostringstream stream{};
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  [-m MODE] [-a ]\n"
+			"\n"
+			"OPTIONS\n"
+			"  -m, --mode MODE  Mm (choices: fast, safe, audit) (default: safe)\n"
+			"  -a               (choices: quick, fast)\n"
+			"\n");
+	}
+	SECTION("print choices and default")
+	{
+		parser.parse({"", "-m", "audit"});
+		std::ostringstream stream{};
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  [-m MODE]\n"
+			"\n"
+			"OPTIONS\n"
+			"  -m, --mode MODE  Mm (choices: fast, safe, audit) (default: safe)\n"
+			"\n");
+	}
+	SECTION("disabled choices in help")
+	{
+		parser.setChoicesIntro("");
+		std::ostringstream stream{};
+		stream << parser;
+		REQUIRE(stream.str() ==
+			"USAGE\n"
+			"  [-m MODE]\n"
+			"\n"
+			"OPTIONS\n"
+			"  -m, --mode MODE  Mm (default: safe)\n"
+			"\n");
+	}
+}